@@ -0,0 +1,374 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class method definitions for IPv4/TCP one's complement
+// checksum kernel
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <string.h>
+
+#include "tcpChksum.h"
+
+#ifdef TCP_CHKSUM_SIMD_SUPPORTED
+#include <immintrin.h>
+#endif
+
+// The kernels sum native order words, which need swapping at the end on little endian hosts
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define TCP_CHKSUM_SWAP16(_x) (_x)
+#else
+#define TCP_CHKSUM_SWAP16(_x) ((((_x) >> 8) | ((_x) << 8)) & 0xffff)
+#endif
+
+// Selected kernel, resolved on first use
+tcpChksum::chksumEngine_t tcpChksum::engine = tcpChksum::CHKSUM_AUTO;
+
+// --------------------------------------------------
+// Check whether a kernel is available on this CPU
+// --------------------------------------------------
+
+bool tcpChksum::engineSupported (chksumEngine_t engineIn)
+{
+    switch (engineIn)
+    {
+    case CHKSUM_SCALAR:
+        return true;
+
+#ifdef TCP_CHKSUM_SIMD_SUPPORTED
+    case CHKSUM_SSE2:
+        return __builtin_cpu_supports("sse2");
+
+    case CHKSUM_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+
+    default:
+        return false;
+    }
+}
+
+// --------------------------------------------------
+// Select a kernel, falling back to the best
+// supported if the requested one isn't available
+// --------------------------------------------------
+
+tcpChksum::chksumEngine_t tcpChksum::setEngine (chksumEngine_t engineIn)
+{
+    if (engineIn != CHKSUM_AUTO && engineSupported(engineIn))
+    {
+        engine                         = engineIn;
+    }
+    else if (engineSupported(CHKSUM_AVX2))
+    {
+        engine                         = CHKSUM_AVX2;
+    }
+    else if (engineSupported(CHKSUM_SSE2))
+    {
+        engine                         = CHKSUM_SSE2;
+    }
+    else
+    {
+        engine                         = CHKSUM_SCALAR;
+    }
+
+    return engine;
+}
+
+tcpChksum::chksumEngine_t tcpChksum::getEngine (void)
+{
+    return (engine == CHKSUM_AUTO) ? setEngine(CHKSUM_AUTO) : engine;
+}
+
+// --------------------------------------------------
+// One's complement sum of a byte buffer
+// --------------------------------------------------
+
+uint32_t tcpChksum::sum (const uint8_t* buf, uint32_t len, uint32_t init)
+{
+    uint64_t native;
+
+    switch (getEngine())
+    {
+#ifdef TCP_CHKSUM_SIMD_SUPPORTED
+    case CHKSUM_AVX2:
+        native                         = sumAvx2(buf, len);
+        break;
+
+    case CHKSUM_SSE2:
+        native                         = sumSse2(buf, len);
+        break;
+#endif
+    default:
+        native                         = sumScalar(buf, len);
+        break;
+    }
+
+    // Single fold of the wide sum, then convert to network order and add the initial value
+    uint32_t folded                    = fold(native);
+
+    return fold((uint64_t)TCP_CHKSUM_SWAP16(folded) + init);
+}
+
+// --------------------------------------------------
+// Self-test of all supported kernels against the
+// byte at a time reference, over a range of lengths
+// and buffer alignments, and over a buffer of all
+// ones long enough to fold the vector accumulators
+// --------------------------------------------------
+
+uint32_t tcpChksum::selfTest (bool verbose)
+{
+    uint8_t        buf[SELF_TEST_MAX_LEN + SELF_TEST_OFFSETS];
+    uint32_t       errors              = 0;
+    uint32_t       lfsr                = 0xace1u;
+
+    // Fill the buffer with pseudo-random data
+    for (uint32_t idx = 0; idx < sizeof(buf); idx++)
+    {
+        lfsr                           = (lfsr >> 1) ^ ((lfsr & 1) ? 0xb400u : 0);
+        buf[idx]                       = lfsr & 0xff;
+    }
+
+    for (uint32_t offset = 0; offset < SELF_TEST_OFFSETS; offset++)
+    {
+        // The reference for each length is extended from that for the length before, with
+        // the last byte added as the high byte of a word if at an even index
+        uint64_t ref                   = 0;
+
+        for (uint32_t len = 0; len <= SELF_TEST_MAX_LEN; len++)
+        {
+            if (len != 0)
+            {
+                uint32_t last          = buf[offset + len - 1];
+                ref                    += ((len - 1) & 1) ? last : last << 8;
+            }
+
+            errors                     += checkKernels(&buf[offset], len, ref, verbose);
+        }
+    }
+
+    // Maximal word values, to catch any lane accumulator overflowing
+    uint8_t*       ones                = new uint8_t[SELF_TEST_LONG_LEN];
+
+    for (uint32_t idx = 0; idx < SELF_TEST_LONG_LEN; idx++)
+    {
+        ones[idx]                      = 0xff;
+    }
+
+    errors                             += checkKernels(ones, SELF_TEST_LONG_LEN, sumBytewise(ones, SELF_TEST_LONG_LEN), verbose);
+
+    delete [] ones;
+
+    return errors;
+}
+
+// --------------------------------------------------
+// Byte at a time reference sum
+// --------------------------------------------------
+
+uint64_t tcpChksum::sumBytewise (const uint8_t* buf, uint32_t len)
+{
+    uint64_t acc                       = 0;
+
+    for (uint32_t idx = 0; idx < len; idx++)
+    {
+        acc                            += (idx & 1) ? buf[idx] : (uint32_t)buf[idx] << 8;
+    }
+
+    return acc;
+}
+
+// --------------------------------------------------
+// Compare the supported kernels against a reference
+// sum for a buffer
+// --------------------------------------------------
+
+uint32_t tcpChksum::checkKernels (const uint8_t* buf, uint32_t len, uint64_t ref, bool verbose)
+{
+    static const chksumEngine_t engines[] = {CHKSUM_SCALAR, CHKSUM_SSE2, CHKSUM_AVX2};
+
+    chksumEngine_t saved_engine        = engine;
+    uint32_t       exp                 = fold(ref);
+    uint32_t       errors              = 0;
+
+    for (uint32_t eidx = 0; eidx < sizeof(engines)/sizeof(engines[0]); eidx++)
+    {
+        if (!engineSupported(engines[eidx]))
+        {
+            continue;
+        }
+
+        engine                         = engines[eidx];
+
+        uint32_t got                   = sum(buf, len);
+
+        if (got != exp)
+        {
+            if (verbose)
+            {
+                printf("tcpChksum::selfTest() : ***ERROR. engine %d, len %d: got 0x%04x, expected 0x%04x\n",
+                       engine, len, got, exp);
+            }
+            errors++;
+        }
+    }
+
+    engine                             = saved_engine;
+
+    return errors;
+}
+
+// --------------------------------------------------
+// Scalar kernel, adding 64 bit words with end around
+// carry
+// --------------------------------------------------
+
+uint64_t tcpChksum::sumScalar (const uint8_t* buf, uint32_t len)
+{
+    uint64_t acc                       = 0;
+    uint64_t word64;
+    uint32_t word32;
+    uint16_t word16;
+
+    while (len >= 8)
+    {
+        memcpy(&word64, buf, 8);
+
+        acc                            += word64;
+        acc                            += (acc < word64) ? 1 : 0;
+
+        buf                            += 8;
+        len                            -= 8;
+    }
+
+    // Any tail words are added to an accumulator which can't then overflow
+    acc                                = (acc & 0xffffffffULL) + (acc >> 32);
+
+    if (len >= 4)
+    {
+        memcpy(&word32, buf, 4);
+        acc                            += word32;
+        buf                            += 4;
+        len                            -= 4;
+    }
+
+    if (len >= 2)
+    {
+        memcpy(&word16, buf, 2);
+        acc                            += word16;
+        buf                            += 2;
+        len                            -= 2;
+    }
+
+    // An odd last byte is the high byte of a big endian word, which is the
+    // first byte in memory
+    if (len)
+    {
+        word16                         = 0;
+        memcpy(&word16, buf, 1);
+        acc                            += word16;
+    }
+
+    return acc;
+}
+
+#ifdef TCP_CHKSUM_SIMD_SUPPORTED
+
+// --------------------------------------------------
+// SSE2 kernel, zero extending 16 bit words into four
+// 32 bit lane accumulators
+// --------------------------------------------------
+
+__attribute__((target("sse2")))
+uint64_t tcpChksum::sumSse2 (const uint8_t* buf, uint32_t len)
+{
+    uint64_t acc                       = 0;
+    uint32_t lanes[4];
+    __m128i  zero                      = _mm_setzero_si128();
+
+    while (len >= 16)
+    {
+        __m128i  vacc                  = _mm_setzero_si128();
+        uint32_t iters                 = len / 16;
+
+        iters                          = (iters > SIMD_BLOCK_ITERS) ? SIMD_BLOCK_ITERS : iters;
+
+        for (uint32_t idx = 0; idx < iters; idx++)
+        {
+            __m128i data               = _mm_loadu_si128((const __m128i*)buf);
+
+            vacc                       = _mm_add_epi32(vacc, _mm_unpacklo_epi16(data, zero));
+            vacc                       = _mm_add_epi32(vacc, _mm_unpackhi_epi16(data, zero));
+
+            buf                        += 16;
+        }
+
+        len                            -= iters * 16;
+
+        _mm_storeu_si128((__m128i*)lanes, vacc);
+        acc                            += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return acc + sumScalar(buf, len);
+}
+
+// --------------------------------------------------
+// AVX2 kernel, zero extending 16 bit words into eight
+// 32 bit lane accumulators
+// --------------------------------------------------
+
+__attribute__((target("avx2")))
+uint64_t tcpChksum::sumAvx2 (const uint8_t* buf, uint32_t len)
+{
+    uint64_t acc                       = 0;
+    uint32_t lanes[8];
+    __m256i  zero                      = _mm256_setzero_si256();
+
+    while (len >= 32)
+    {
+        __m256i  vacc                  = _mm256_setzero_si256();
+        uint32_t iters                 = len / 32;
+
+        iters                          = (iters > SIMD_BLOCK_ITERS) ? SIMD_BLOCK_ITERS : iters;
+
+        for (uint32_t idx = 0; idx < iters; idx++)
+        {
+            __m256i data               = _mm256_loadu_si256((const __m256i*)buf);
+
+            vacc                       = _mm256_add_epi32(vacc, _mm256_unpacklo_epi16(data, zero));
+            vacc                       = _mm256_add_epi32(vacc, _mm256_unpackhi_epi16(data, zero));
+
+            buf                        += 32;
+        }
+
+        len                            -= iters * 32;
+
+        _mm256_storeu_si256((__m256i*)lanes, vacc);
+        acc                            += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+                                          (uint64_t)lanes[4] + lanes[5] + lanes[6] + lanes[7];
+    }
+
+    // Clear the upper lanes before dropping to the (non-VEX) SSE2 kernel for the tail
+    _mm256_zeroupper();
+
+    return acc + sumSse2(buf, len);
+}
+
+#endif
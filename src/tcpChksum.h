@@ -0,0 +1,127 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class header for IPv4/TCP one's complement checksum kernel
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_CHKSUM_H_
+#define _TCP_CHKSUM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Vector kernels only available for x86 with GCC compatible compilers
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TCP_CHKSUM_SIMD_SUPPORTED
+#endif
+
+class tcpChksum
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    // Maximum number of vector iterations before the 32 bit lane accumulators
+    // must be folded into the 64 bit sum to avoid overflow
+    static const uint32_t SIMD_BLOCK_ITERS     = 16384;
+
+    // Number of lengths and alignment offsets tested in the self-test, and the length of
+    // its all ones buffer, spanning several accumulator blocks of the widest kernel
+    static const uint32_t SELF_TEST_MAX_LEN    = 2100;
+    static const uint32_t SELF_TEST_OFFSETS    = 32;
+    static const uint32_t SELF_TEST_LONG_LEN   = 3 * SIMD_BLOCK_ITERS * 32 + 17;
+
+    // --------------------------------------------
+    // Type definitions
+    // --------------------------------------------
+
+    // Available checksum kernels
+    typedef enum {
+        CHKSUM_SCALAR = 0,
+        CHKSUM_SSE2,
+        CHKSUM_AVX2,
+        CHKSUM_AUTO
+    } chksumEngine_t;
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // One's complement sum of a packed byte buffer as big endian 16 bit words (an odd
+    // last byte is the high byte of a word), added to init and folded to 16 bits. The
+    // result is not inverted.
+    static uint32_t       sum          (const uint8_t* buf, uint32_t len, uint32_t init = 0);
+
+    // Fold a one's complement sum of any width to 16 bits, with end around carry
+    static uint32_t       fold         (uint64_t sum) {
+                                            sum = (sum & 0xffffffffULL) + (sum >> 32);
+                                            sum = (sum & 0xffff) + (sum >> 16);
+                                            sum = (sum & 0xffff) + (sum >> 16);
+                                            return (uint32_t)((sum & 0xffff) + (sum >> 16));}
+
+    // Final checksum value from a sum of any width
+    static uint32_t       finish       (uint64_t sum) {return ~fold(sum) & 0xffff;};
+
+    // Incrementally update a final checksum for a 16 bit field changing from old_val
+    // to new_val (RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m'))
+    static uint32_t       update       (uint32_t chksum, uint32_t old_val, uint32_t new_val) {
+                                            return finish((~chksum & 0xffff) + (~old_val & 0xffff) + (new_val & 0xffff));}
+
+    // Select the kernel used (returns kernel actually selected)
+    static chksumEngine_t setEngine    (chksumEngine_t engineIn);
+    static chksumEngine_t getEngine    (void);
+    static bool           engineSupported (chksumEngine_t engineIn);
+
+    // Check all supported kernels against a byte at a time reference. Returns the
+    // number of mismatches found.
+    static uint32_t       selfTest     (bool verbose = false);
+
+private:
+
+    // --------------------------------------------
+    // Private methods
+    // --------------------------------------------
+
+    // Byte at a time reference sum of big endian 16 bit words, not folded
+    static uint64_t       sumBytewise  (const uint8_t* buf, uint32_t len);
+
+    // Compare all supported kernels' sums of a buffer with the reference sum, returning
+    // the number of mismatches
+    static uint32_t       checkKernels (const uint8_t* buf, uint32_t len, uint64_t ref, bool verbose);
+
+    // Kernels returning a native byte order sum, not folded
+    static uint64_t       sumScalar    (const uint8_t* buf, uint32_t len);
+
+#ifdef TCP_CHKSUM_SIMD_SUPPORTED
+    static uint64_t       sumSse2      (const uint8_t* buf, uint32_t len);
+    static uint64_t       sumAvx2      (const uint8_t* buf, uint32_t len);
+#endif
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Selected kernel (resolved on first use if CHKSUM_AUTO)
+    static chksumEngine_t engine;
+};
+
+#endif
@@ -0,0 +1,430 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class method definitions for Ethernet CRC32 calculation engine
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <string.h>
+
+#include "tcpCrc32.h"
+
+#ifdef TCP_CRC32_CLMUL_SUPPORTED
+#include <immintrin.h>
+#endif
+
+// The slicing methods load little endian words
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define TCP_CRC32_BIG_ENDIAN
+#endif
+
+// --------------------------------------------------
+// Constructor. Generate the slicing tables for the
+// polynomial and select an engine
+// --------------------------------------------------
+
+tcpCrc32::tcpCrc32 (uint32_t polyIn, crcEngine_t engineIn) : poly(polyIn)
+{
+    // Standard byte at a time table
+    for (uint32_t byte = 0; byte < 256; byte++)
+    {
+        uint32_t val                   = byte;
+        for (int i = 0; i < 8; i++)
+        {
+            val                        = (val & 1) ? (val >> 1) ^ poly : val >> 1;
+        }
+        table[0][byte]                 = val;
+    }
+
+    // Each subsequent table is the CRC of the previous table's entry followed by a zero byte
+    for (uint32_t byte = 0; byte < 256; byte++)
+    {
+        for (int slice = 1; slice < 16; slice++)
+        {
+            uint32_t prev              = table[slice-1][byte];
+            table[slice][byte]         = (prev >> 8) ^ table[0][prev & 0xff];
+        }
+    }
+
+    setEngine(engineIn);
+}
+
+// --------------------------------------------------
+// Check whether an engine is available
+// --------------------------------------------------
+
+bool tcpCrc32::engineSupported (crcEngine_t engineIn)
+{
+    switch (engineIn)
+    {
+    case CRC_BITWISE:
+        return true;
+
+    case CRC_SLICE8:
+    case CRC_SLICE16:
+#ifdef TCP_CRC32_BIG_ENDIAN
+        return false;
+#else
+        return true;
+#endif
+
+    case CRC_CLMUL:
+#ifdef TCP_CRC32_CLMUL_SUPPORTED
+        // Folding constants are only for the Ethernet polynomial
+        return poly == POLY && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#else
+        return false;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+// --------------------------------------------------
+// Select a CRC engine, falling back to the best
+// supported if the requested one isn't available
+// --------------------------------------------------
+
+tcpCrc32::crcEngine_t tcpCrc32::setEngine (crcEngine_t engineIn)
+{
+    if (engineIn != CRC_AUTO && engineSupported(engineIn))
+    {
+        engine                         = engineIn;
+    }
+    else if (engineSupported(CRC_CLMUL))
+    {
+        engine                         = CRC_CLMUL;
+    }
+    else if (engineSupported(CRC_SLICE16))
+    {
+        engine                         = CRC_SLICE16;
+    }
+    else
+    {
+        engine                         = CRC_BITWISE;
+    }
+
+    return engine;
+}
+
+// --------------------------------------------------
+// Update a running CRC with the selected engine
+// --------------------------------------------------
+
+uint32_t tcpCrc32::update (uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    switch (engine)
+    {
+#ifdef TCP_CRC32_CLMUL_SUPPORTED
+    case CRC_CLMUL:
+        return updateClmul(crc, buf, len);
+#endif
+    case CRC_SLICE16:
+        return updateSlice16(crc, buf, len);
+
+    case CRC_SLICE8:
+        return updateSlice8(crc, buf, len);
+
+    default:
+        return updateBitwise(crc, buf, len, poly);
+    }
+}
+
+// --------------------------------------------------
+// Bit at a time reference CRC (as original tcpIpPg
+// implementation)
+// --------------------------------------------------
+
+uint32_t tcpCrc32::updateBitwise (uint32_t crc, const uint8_t* buf, uint32_t len, uint32_t poly)
+{
+    uint32_t val;
+
+    while (len--)
+    {
+        val                            = (crc ^ *buf++) & 0xFF;
+        for (int i = 0; i < 8; i++)
+        {
+            val                        = (val & 1) ? (val >> 1) ^ poly : val >> 1;
+        }
+        crc                            = val ^ crc >> 8;
+    }
+
+    return crc;
+}
+
+// --------------------------------------------------
+// Table driven byte at a time CRC
+// --------------------------------------------------
+
+uint32_t tcpCrc32::updateSlice1 (uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    while (len--)
+    {
+        crc                            = (crc >> 8) ^ table[0][(crc ^ *buf++) & 0xff];
+    }
+
+    return crc;
+}
+
+// --------------------------------------------------
+// Slicing-by-8 CRC, with byte at a time tail
+// --------------------------------------------------
+
+uint32_t tcpCrc32::updateSlice8 (uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    uint32_t word[2];
+
+    while (len >= 8)
+    {
+        memcpy(word, buf, 8);
+
+        word[0]                        ^= crc;
+
+        crc                            = table[7][ word[0]        & 0xff] ^
+                                         table[6][(word[0] >>  8) & 0xff] ^
+                                         table[5][(word[0] >> 16) & 0xff] ^
+                                         table[4][ word[0] >> 24        ] ^
+                                         table[3][ word[1]        & 0xff] ^
+                                         table[2][(word[1] >>  8) & 0xff] ^
+                                         table[1][(word[1] >> 16) & 0xff] ^
+                                         table[0][ word[1] >> 24        ];
+        buf                            += 8;
+        len                            -= 8;
+    }
+
+    return updateSlice1(crc, buf, len);
+}
+
+// --------------------------------------------------
+// Slicing-by-16 CRC, with slicing-by-8 tail
+// --------------------------------------------------
+
+uint32_t tcpCrc32::updateSlice16 (uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    uint32_t word[4];
+
+    while (len >= 16)
+    {
+        memcpy(word, buf, 16);
+
+        word[0]                        ^= crc;
+
+        crc                            = table[15][ word[0]        & 0xff] ^
+                                         table[14][(word[0] >>  8) & 0xff] ^
+                                         table[13][(word[0] >> 16) & 0xff] ^
+                                         table[12][ word[0] >> 24        ] ^
+                                         table[11][ word[1]        & 0xff] ^
+                                         table[10][(word[1] >>  8) & 0xff] ^
+                                         table[ 9][(word[1] >> 16) & 0xff] ^
+                                         table[ 8][ word[1] >> 24        ] ^
+                                         table[ 7][ word[2]        & 0xff] ^
+                                         table[ 6][(word[2] >>  8) & 0xff] ^
+                                         table[ 5][(word[2] >> 16) & 0xff] ^
+                                         table[ 4][ word[2] >> 24        ] ^
+                                         table[ 3][ word[3]        & 0xff] ^
+                                         table[ 2][(word[3] >>  8) & 0xff] ^
+                                         table[ 1][(word[3] >> 16) & 0xff] ^
+                                         table[ 0][ word[3] >> 24        ];
+        buf                            += 16;
+        len                            -= 16;
+    }
+
+    return updateSlice8(crc, buf, len);
+}
+
+#ifdef TCP_CRC32_CLMUL_SUPPORTED
+
+// --------------------------------------------------
+// Carry-less multiply folding CRC for the Ethernet
+// polynomial (see Intel's "Fast CRC Computation for
+// Generic Polynomials Using PCLMULQDQ Instruction").
+// Folds four 128 bit lanes in parallel, then reduces
+// to 32 bits with a Barrett reduction. Lengths less
+// than CLMUL_MIN_LEN, and any tail, use the tables.
+// --------------------------------------------------
+
+__attribute__((target("pclmul,sse4.1")))
+uint32_t tcpCrc32::updateClmul (uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    // Folding constants for 0xEDB88320: x^(4*128+32), x^(4*128-32), x^(128+32), x^(128-32),
+    // x^64 and the Barrett constants P(x)' and u'
+    static const uint64_t k1k2[2]      = {0x0154442bd4ULL, 0x01c6e41596ULL};
+    static const uint64_t k3k4[2]      = {0x01751997d0ULL, 0x00ccaa009eULL};
+    static const uint64_t k5k0[2]      = {0x0163cd6124ULL, 0x0000000000ULL};
+    static const uint64_t pu[2]        = {0x01db710641ULL, 0x01f7011641ULL};
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    if (len < CLMUL_MIN_LEN)
+    {
+        return updateSlice8(crc, buf, len);
+    }
+
+    // Load first 64 bytes and fold in the running CRC
+    x1                                 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    x2                                 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    x3                                 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    x4                                 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1                                 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    x0                                 = _mm_loadu_si128((const __m128i*)k1k2);
+
+    buf                                += 64;
+    len                                -= 64;
+
+    // Fold 64 bytes at a time in four parallel lanes
+    while (len >= 64)
+    {
+        x5                             = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6                             = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7                             = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8                             = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1                             = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2                             = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3                             = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4                             = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5                             = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+        y6                             = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+        y7                             = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+        y8                             = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+        x1                             = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2                             = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3                             = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4                             = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        buf                            += 64;
+        len                            -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0                                 = _mm_loadu_si128((const __m128i*)k3k4);
+
+    x5                                 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1                                 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1                                 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5                                 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1                                 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1                                 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5                                 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1                                 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1                                 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Fold any remaining 16 byte blocks
+    while (len >= 16)
+    {
+        x2                             = _mm_loadu_si128((const __m128i*)buf);
+        x5                             = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1                             = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1                             = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        buf                            += 16;
+        len                            -= 16;
+    }
+
+    // Fold 128 bits to 64 bits
+    x2                                 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3                                 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1                                 = _mm_srli_si128(x1, 8);
+    x1                                 = _mm_xor_si128(x1, x2);
+
+    x0                                 = _mm_loadl_epi64((const __m128i*)k5k0);
+
+    x2                                 = _mm_srli_si128(x1, 4);
+    x1                                 = _mm_and_si128(x1, x3);
+    x1                                 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1                                 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduce to 32 bits
+    x0                                 = _mm_loadu_si128((const __m128i*)pu);
+
+    x2                                 = _mm_and_si128(x1, x3);
+    x2                                 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2                                 = _mm_and_si128(x2, x3);
+    x2                                 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1                                 = _mm_xor_si128(x1, x2);
+
+    crc                                = _mm_extract_epi32(x1, 1);
+
+    // Finish off any tail bytes with the tables
+    return updateSlice8(crc, buf, len);
+}
+
+#endif
+
+// --------------------------------------------------
+// Self-test of all supported engines against the
+// bitwise reference, over a range of lengths and
+// buffer alignments.
+// --------------------------------------------------
+
+uint32_t tcpCrc32::selfTest (bool verbose)
+{
+    static const crcEngine_t engines[] = {CRC_SLICE8, CRC_SLICE16, CRC_CLMUL};
+
+    uint8_t     buf[SELF_TEST_MAX_LEN + SELF_TEST_OFFSETS];
+    uint32_t    errors                 = 0;
+    uint32_t    lfsr                   = 0xace1u;
+    crcEngine_t saved_engine           = engine;
+
+    // Fill the buffer with pseudo-random data
+    for (uint32_t idx = 0; idx < sizeof(buf); idx++)
+    {
+        lfsr                           = (lfsr >> 1) ^ ((lfsr & 1) ? 0xb400u : 0);
+        buf[idx]                       = lfsr & 0xff;
+    }
+
+    for (uint32_t offset = 0; offset < SELF_TEST_OFFSETS; offset++)
+    {
+        // The reference for each length is extended from that for the length before
+        uint32_t exp                   = INIT;
+
+        for (uint32_t len = 0; len <= SELF_TEST_MAX_LEN; len++)
+        {
+            exp                        = (len == 0) ? INIT : updateBitwise(exp, &buf[offset + len - 1], 1, poly);
+
+            for (uint32_t eidx = 0; eidx < sizeof(engines)/sizeof(engines[0]); eidx++)
+            {
+                if (!engineSupported(engines[eidx]))
+                {
+                    continue;
+                }
+
+                engine                 = engines[eidx];
+
+                uint32_t got           = update(INIT, &buf[offset], len);
+
+                if (exp != got)
+                {
+                    if (verbose)
+                    {
+                        printf("tcpCrc32::selfTest() : ***ERROR. engine %d, offset %d, len %d: got 0x%08x, expected 0x%08x\n",
+                               engine, offset, len, got, exp);
+                    }
+                    errors++;
+                }
+            }
+        }
+    }
+
+    engine                             = saved_engine;
+
+    return errors;
+}
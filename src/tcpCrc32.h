@@ -0,0 +1,130 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class header for Ethernet CRC32 calculation engine
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_CRC32_H_
+#define _TCP_CRC32_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Carry-less multiply kernel only available for x86 with GCC compatible compilers
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TCP_CRC32_CLMUL_SUPPORTED
+#endif
+
+class tcpCrc32
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    // CRC32 parameters
+    static const uint32_t POLY                 = 0xEDB88320;  /* 0x04C11DB7 bit reversed */
+    static const uint32_t INIT                 = 0xFFFFFFFF;
+
+    // Minimum buffer length for which the carry-less multiply kernel is used
+    static const uint32_t CLMUL_MIN_LEN        = 64; // BYTES
+
+    // Number of lengths and alignment offsets tested in the self-test
+    static const uint32_t SELF_TEST_MAX_LEN    = 2100;
+    static const uint32_t SELF_TEST_OFFSETS    = 16;
+
+    // --------------------------------------------
+    // Type definitions
+    // --------------------------------------------
+
+    // Available CRC calculation engines
+    typedef enum {
+        CRC_BITWISE = 0,
+        CRC_SLICE8,
+        CRC_SLICE16,
+        CRC_CLMUL,
+        CRC_AUTO
+    } crcEngine_t;
+
+    // --------------------------------------------
+    // Constructor
+    // --------------------------------------------
+
+    tcpCrc32 (uint32_t polyIn = POLY, crcEngine_t engineIn = CRC_AUTO);
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Calculate the (inverted) CRC over a packed byte buffer
+    uint32_t       calc                (const uint8_t* buf, uint32_t len, uint32_t init = INIT) {
+                                            return update(init, buf, len) ^ 0xFFFFFFFF;}
+
+    // Update a running (uninverted) CRC with a packed byte buffer
+    uint32_t       update              (uint32_t crc, const uint8_t* buf, uint32_t len);
+
+    // Select the engine used for calculations. Returns the engine actually
+    // selected, which falls back to the fastest supported if not available.
+    crcEngine_t    setEngine           (crcEngine_t engineIn);
+    crcEngine_t    getEngine           (void) {return engine;};
+
+    // Check whether an engine is supported for this polynomial on this CPU
+    bool           engineSupported     (crcEngine_t engineIn);
+
+    // Polynomial this engine was constructed for
+    uint32_t       getPoly             (void) {return poly;};
+
+    // Check all supported engines against the bitwise reference. Returns the
+    // number of mismatches found.
+    uint32_t       selfTest            (bool verbose = false);
+
+    // Bit at a time reference calculation, returning a running (uninverted) CRC
+    static uint32_t updateBitwise      (uint32_t crc, const uint8_t* buf, uint32_t len, uint32_t poly = POLY);
+
+private:
+
+    // --------------------------------------------
+    // Private methods
+    // --------------------------------------------
+
+    uint32_t       updateSlice1        (uint32_t crc, const uint8_t* buf, uint32_t len);
+    uint32_t       updateSlice8        (uint32_t crc, const uint8_t* buf, uint32_t len);
+    uint32_t       updateSlice16       (uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#ifdef TCP_CRC32_CLMUL_SUPPORTED
+    uint32_t       updateClmul         (uint32_t crc, const uint8_t* buf, uint32_t len);
+#endif
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Polynomial (bit reversed) for the tables
+    uint32_t       poly;
+
+    // Currently selected engine
+    crcEngine_t    engine;
+
+    // Slicing tables, with table[0] the standard byte at a time table
+    uint32_t       table[16][256];
+};
+
+#endif
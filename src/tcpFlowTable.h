@@ -0,0 +1,394 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class template for a hash table of per-connection state,
+// keyed on the TCP/IPv4 4-tuple, with pre-allocated slots and
+// open addressing, for constant time lookup of the flow of a
+// received packet
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_FLOW_TABLE_H_
+#define _TCP_FLOW_TABLE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+template <class T> class tcpFlowTable
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    static const uint32_t DEFAULT_MAX_FLOWS    = 1024;
+
+    // Multiplier for Fibonacci hashing (2^64 divided by the golden ratio)
+    static const uint64_t HASH_MULT            = 0x9e3779b97f4a7c15ULL;
+
+    // Self-test table size, number of keys, and the most candidate keys searched for
+    // ones with each home slot wanted
+    static const uint32_t SELF_TEST_MAX_FLOWS  = 16;
+    static const uint32_t SELF_TEST_KEYS       = 12;
+    static const uint32_t SELF_TEST_CANDIDATES = 1 << 20;
+
+    // --------------------------------------------
+    // Type definitions
+    // --------------------------------------------
+
+    // Key of a flow: the local and remote IPv4 addresses and TCP ports
+    typedef struct {
+        uint32_t local_addr;
+        uint32_t remote_addr;
+        uint32_t local_port;
+        uint32_t remote_port;
+    } flowKey_t;
+
+    // --------------------------------------------
+    // Constructor and destructor
+    // --------------------------------------------
+
+    // Table for up to maxFlowsIn flows, with its slots allocated when the first is added
+    tcpFlowTable (uint32_t maxFlowsIn = DEFAULT_MAX_FLOWS) : slots(NULL), num_flows(0)
+    {
+        setMaxFlows(maxFlowsIn);
+    };
+
+    ~tcpFlowTable ()
+    {
+        delete [] slots;
+    };
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Set the most flows allowed, freeing any slots, which are reallocated for the new
+    // maximum when a flow is next added. The number of slots is a power of two of at
+    // least twice the maximum, so probe sequences stay short when full. Returns false,
+    // leaving the table unchanged, if it isn't empty.
+    bool           setMaxFlows         (uint32_t maxFlowsIn)
+    {
+        if (num_flows != 0)
+        {
+            return false;
+        }
+
+        delete [] slots;
+        slots                          = NULL;
+
+        // At least two slots, so that the hash shift is less than 64
+        num_slots                      = 2;
+        hash_shift                     = 63;
+        while (num_slots < 2*maxFlowsIn)
+        {
+            num_slots                  <<= 1;
+            hash_shift--;
+        }
+
+        max_flows                      = maxFlowsIn;
+        mask                           = num_slots - 1;
+
+        return true;
+    };
+
+    // Status of the table
+    bool           empty               (void) {return num_flows == 0;};
+    uint32_t       size                (void) {return num_flows;};
+    uint32_t       maxFlows            (void) {return max_flows;};
+
+    // Add a flow with its initial state. Returns a pointer to the state held in the table,
+    // or NULL if the table is full or the flow is already present. The pointer is valid
+    // until the next remove or clear.
+    T*             add                 (const flowKey_t &key, const T &state)
+    {
+        if (num_flows == max_flows || find(key) != NULL)
+        {
+            return NULL;
+        }
+
+        if (slots == NULL)
+        {
+            slots                      = new slot_t[num_slots];
+            clear();
+        }
+
+        uint32_t idx                   = home(key);
+
+        while (slots[idx].used)
+        {
+            idx                        = (idx + 1) & mask;
+        }
+
+        slots[idx].key                 = key;
+        slots[idx].state               = state;
+        slots[idx].used                = true;
+        num_flows++;
+
+        return &slots[idx].state;
+    };
+
+    // Find a flow's state, or NULL if not present
+    T*             find                (const flowKey_t &key)
+    {
+        if (num_flows == 0)
+        {
+            return NULL;
+        }
+
+        for (uint32_t idx = home(key); slots[idx].used; idx = (idx + 1) & mask)
+        {
+            if (match(slots[idx].key, key))
+            {
+                return &slots[idx].state;
+            }
+        }
+
+        return NULL;
+    };
+
+    // Remove a flow. Returns false if not present. The flows after it in its probe
+    // sequence are moved back over the gap, so no deleted markers are left to lengthen
+    // later lookups.
+    bool           remove              (const flowKey_t &key)
+    {
+        if (num_flows == 0)
+        {
+            return false;
+        }
+
+        uint32_t idx                   = home(key);
+
+        while (slots[idx].used && !match(slots[idx].key, key))
+        {
+            idx                        = (idx + 1) & mask;
+        }
+
+        if (!slots[idx].used)
+        {
+            return false;
+        }
+
+        for (uint32_t next = (idx + 1) & mask; slots[next].used; next = (next + 1) & mask)
+        {
+            // A flow can fill the gap if its home slot isn't cyclically after the gap
+            // and up to its current slot
+            uint32_t h                 = home(slots[next].key);
+
+            if (((next - h) & mask) >= ((next - idx) & mask))
+            {
+                slots[idx]             = slots[next];
+                idx                    = next;
+            }
+        }
+
+        slots[idx].used                = false;
+        num_flows--;
+
+        return true;
+    };
+
+    // Remove all the flows
+    void           clear               (void)
+    {
+        for (uint32_t idx = 0; slots != NULL && idx < num_slots; idx++)
+        {
+            slots[idx].used            = false;
+        }
+
+        num_flows                      = 0;
+    };
+
+    // Check adding, finding and removing flows with keys sharing home slots: a run of
+    // them from the last slot, wrapping to the start, with others homed on the first
+    // two slots displaced along it. Flows are removed from the middle of the run, and
+    // every key, present or removed, looked up. Returns the number of errors found.
+    static uint32_t selfTest           (bool verbose = false)
+    {
+        selfTestTable_t            table(SELF_TEST_MAX_FLOWS);
+        selfTestTable_t::flowKey_t keys[SELF_TEST_KEYS];
+        bool                       present[SELF_TEST_KEYS];
+        uint32_t                   errors = 0;
+        uint32_t                   cand   = 0;
+
+        // Find keys for the home slots wanted: six on the last slot, four on the first
+        // and two on the second
+        for (uint32_t idx = 0; idx < SELF_TEST_KEYS; idx++)
+        {
+            uint32_t want              = (idx < 6) ? table.mask : (idx < 10) ? 0 : 1;
+
+            do
+            {
+                keys[idx].local_addr   = 0xc0a80001;
+                keys[idx].remote_addr  = 0x0a000000 + cand;
+                keys[idx].local_port   = 80;
+                keys[idx].remote_port  = 0x1000 + (cand & 0xfff);
+                cand++;
+            } while (table.home(keys[idx]) != want && cand < SELF_TEST_CANDIDATES);
+
+            if (table.home(keys[idx]) != want)
+            {
+                if (verbose)
+                {
+                    printf("tcpFlowTable::selfTest() : ***ERROR. No key found with home slot %d\n", want);
+                }
+                return errors + 1;
+            }
+        }
+
+        // Add them all, each with its index as its state, and check that adding one
+        // again fails
+        for (uint32_t idx = 0; idx < SELF_TEST_KEYS; idx++)
+        {
+            uint32_t* state            = table.add(keys[idx], idx);
+
+            present[idx]               = state != NULL;
+            errors                     += present[idx] ? 0 : 1;
+        }
+
+        errors                         += (table.add(keys[0], 0) == NULL) ? 0 : 1;
+        errors                         += checkFlows(table, keys, present, verbose);
+
+        // Remove flows from the middle of the run, before and after it wraps, and one
+        // displaced from the first slot, then check removing one again fails
+        static const uint32_t removes[] = {1, 4, 7};
+
+        for (uint32_t ridx = 0; ridx < sizeof(removes)/sizeof(removes[0]); ridx++)
+        {
+            present[removes[ridx]]     = false;
+            errors                     += table.remove(keys[removes[ridx]]) ? 0 : 1;
+            errors                     += checkFlows(table, keys, present, verbose);
+        }
+
+        errors                         += table.remove(keys[removes[0]]) ? 1 : 0;
+
+        // Add the removed flows back, into the gaps left, then remove all the flows in turn
+        for (uint32_t ridx = 0; ridx < sizeof(removes)/sizeof(removes[0]); ridx++)
+        {
+            present[removes[ridx]]     = table.add(keys[removes[ridx]], removes[ridx]) != NULL;
+            errors                     += present[removes[ridx]] ? 0 : 1;
+        }
+
+        errors                         += checkFlows(table, keys, present, verbose);
+
+        for (uint32_t idx = 0; idx < SELF_TEST_KEYS; idx++)
+        {
+            present[idx]               = false;
+            errors                     += table.remove(keys[idx]) ? 0 : 1;
+            errors                     += checkFlows(table, keys, present, verbose);
+        }
+
+        if (verbose && errors)
+        {
+            printf("tcpFlowTable::selfTest() : ***ERROR. %d errors adding and removing flows\n", errors);
+        }
+
+        return errors;
+    };
+
+private:
+
+    // The self-test uses a table of another state type
+    template <class U> friend class tcpFlowTable;
+
+    // --------------------------------------------
+    // Private type definitions
+    // --------------------------------------------
+
+    typedef struct {
+        flowKey_t  key;
+        bool       used;
+        T          state;
+    } slot_t;
+
+    // Table used by the self-test, with each flow's index as its state
+    typedef tcpFlowTable<uint32_t> selfTestTable_t;
+
+    // Not copyable, as the table owns its slot storage
+    tcpFlowTable (const tcpFlowTable&);
+    tcpFlowTable& operator= (const tcpFlowTable&);
+
+    // --------------------------------------------
+    // Private methods
+    // --------------------------------------------
+
+    // Home slot of a key: the remote address and ports folded into a word with the local
+    // address, and the top log2(num_slots) bits of the product with the hash multiplier
+    // used (Fibonacci hashing)
+    uint32_t       home                (const flowKey_t &key)
+    {
+        uint64_t k                     = ((uint64_t)key.remote_addr << 32) | ((key.remote_port & 0xffff) << 16) | (key.local_port & 0xffff);
+
+        k                              = (k ^ ((uint64_t)key.local_addr * HASH_MULT)) * HASH_MULT;
+
+        return (uint32_t)(k >> hash_shift);
+    };
+
+    static bool    match               (const flowKey_t &a, const flowKey_t &b)
+    {
+        return a.remote_addr == b.remote_addr && a.remote_port == b.remote_port &&
+               a.local_port  == b.local_port  && a.local_addr  == b.local_addr;
+    };
+
+    // Check the self-test's flows: each present key finding its own index as its state,
+    // each removed one not found, and the table's size. Returns the number of errors.
+    template <class TABLE>
+    static uint32_t checkFlows         (TABLE &table, const typename TABLE::flowKey_t* keys, const bool* present, bool verbose)
+    {
+        uint32_t errors                = 0;
+        uint32_t num_present           = 0;
+
+        for (uint32_t idx = 0; idx < SELF_TEST_KEYS; idx++)
+        {
+            uint32_t* state            = table.find(keys[idx]);
+
+            if (present[idx] ? (state == NULL || *state != idx) : (state != NULL))
+            {
+                if (verbose)
+                {
+                    printf("tcpFlowTable::selfTest() : ***ERROR. key %d %s\n", idx,
+                           present[idx] ? "not found, or found with wrong state" : "found after removal");
+                }
+                errors++;
+            }
+
+            num_present                += present[idx] ? 1 : 0;
+        }
+
+        return errors + ((table.size() == num_present) ? 0 : 1);
+    };
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Slot storage (NULL until a flow is added), number of slots (a power of two), index
+    // mask, and the shift taking a hash's top bits as a slot index
+    slot_t*        slots;
+    uint32_t       num_slots;
+    uint32_t       mask;
+    uint32_t       hash_shift;
+
+    // Number of flows in the table, and the most allowed
+    uint32_t       num_flows;
+    uint32_t       max_flows;
+};
+
+#endif
@@ -0,0 +1,118 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class for a pool of pre-allocated, fixed size frame buffers,
+// for keeping received frames beyond their callback
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_FRAME_POOL_H_
+#define _TCP_FRAME_POOL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+class tcpFramePool
+{
+public:
+
+    // --------------------------------------------
+    // Constructor and destructor
+    // --------------------------------------------
+
+    // Allocate numBufsIn buffers of bufSizeIn bytes, all initially free
+    tcpFramePool (uint32_t numBufsIn, uint32_t bufSizeIn) : num_bufs(numBufsIn), buf_size(bufSizeIn)
+    {
+        bufs                           = new uint8_t [num_bufs * buf_size];
+        free_list                      = new uint32_t[num_bufs];
+
+        for (uint32_t idx = 0; idx < num_bufs; idx++)
+        {
+            free_list[idx]             = num_bufs - 1 - idx;
+        }
+
+        num_free                       = num_bufs;
+        high_water                     = 0;
+    };
+
+    ~tcpFramePool ()
+    {
+        delete [] bufs;
+        delete [] free_list;
+    };
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Status of the pool
+    uint32_t       available           (void) {return num_free;};
+    uint32_t       capacity            (void) {return num_bufs;};
+    uint32_t       bufSize             (void) {return buf_size;};
+    uint32_t       inUse               (void) {return num_bufs - num_free;};
+
+    // Largest number of buffers that have been in use at once
+    uint32_t       highWater           (void) {return high_water;};
+
+    // Index of a buffer taken with alloc(), from 0 to capacity()-1
+    uint32_t       index               (const uint8_t* buf) {return (uint32_t)((buf - bufs) / buf_size);};
+
+    // Take a free buffer, or NULL if none left
+    uint8_t*       alloc               (void)
+    {
+        if (num_free == 0)
+        {
+            return NULL;
+        }
+
+        uint8_t* buf                   = &bufs[free_list[--num_free] * buf_size];
+
+        if (inUse() > high_water)
+        {
+            high_water                 = inUse();
+        }
+
+        return buf;
+    };
+
+    // Return a buffer taken with alloc() to the pool
+    void           free                (uint8_t* buf) {free_list[num_free++] = index(buf);};
+
+private:
+
+    // Not copyable, as the pool owns its buffer storage
+    tcpFramePool (const tcpFramePool&);
+    tcpFramePool& operator= (const tcpFramePool&);
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Pool dimensions
+    uint32_t       num_bufs;
+    uint32_t       buf_size;
+
+    // Buffer storage, and stack of free buffer indexes
+    uint8_t*       bufs;
+    uint32_t*      free_list;
+    uint32_t       num_free;
+    uint32_t       high_water;
+};
+
+#endif
@@ -0,0 +1,102 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class for a ring of pre-allocated frame slots, filled by
+// batch packet generation and drained by transmission
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_FRAME_RING_H_
+#define _TCP_FRAME_RING_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+class tcpFrameRing
+{
+public:
+
+    // --------------------------------------------
+    // Constructor and destructor
+    // --------------------------------------------
+
+    // Allocate numSlotsIn slots of slotSizeIn bytes. The slot size must be large enough
+    // for the largest frame to be generated (tcpVProc::ETH_MAX_FRAME_LEN)
+    tcpFrameRing (uint32_t numSlotsIn, uint32_t slotSizeIn) : num_slots(numSlotsIn), slot_size(slotSizeIn)
+    {
+        slots                          = new uint8_t [num_slots * slot_size];
+        lens                           = new uint32_t[num_slots];
+        head                           = 0;
+        tail                           = 0;
+        count                          = 0;
+    };
+
+    ~tcpFrameRing ()
+    {
+        delete [] slots;
+        delete [] lens;
+    };
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Status of the ring
+    bool           empty               (void) {return count == 0;};
+    bool           full                (void) {return count == num_slots;};
+    uint32_t       size                (void) {return count;};
+    uint32_t       capacity            (void) {return num_slots;};
+    uint32_t       slotSize            (void) {return slot_size;};
+
+    // Producer: slot to fill with the next frame, then commit it with its length
+    uint8_t*       nextFree            (void) {return &slots[head * slot_size];};
+    void           push                (uint32_t len) {lens[head] = len; head = (head + 1) % num_slots; count++;};
+
+    // Consumer: oldest frame and its length, then release it
+    uint8_t*       front               (uint32_t &len) {len = lens[tail]; return &slots[tail * slot_size];};
+    void           pop                 (void) {tail = (tail + 1) % num_slots; count--;};
+
+    // Discard all frames
+    void           clear               (void) {head = tail = count = 0;};
+
+private:
+
+    // Not copyable, as the ring owns its slot storage
+    tcpFrameRing (const tcpFrameRing&);
+    tcpFrameRing& operator= (const tcpFrameRing&);
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Ring dimensions
+    uint32_t       num_slots;
+    uint32_t       slot_size;
+
+    // Slot storage and frame length for each slot
+    uint8_t*       slots;
+    uint32_t*      lens;
+
+    // Producer and consumer slot indexes, and number of filled slots
+    uint32_t       head;
+    uint32_t       tail;
+    uint32_t       count;
+};
+
+#endif
@@ -22,6 +22,7 @@
 //=============================================================
 
 #include <cinttypes>
+#include <string.h>
 
 #include "tcpIpPg.h"
 
@@ -29,71 +30,92 @@
 // Calculate CRC32 for ethernet frame.
 // --------------------------------------------------
 
-uint32_t tcpIpPg::crc32(uint32_t *buf, uint32_t len, uint32_t poly, uint32_t init, bool debug)
+uint32_t tcpIpPg::crc32(const uint8_t *buf, uint32_t len, uint32_t poly, uint32_t init, bool debug)
 {
+    // Only the engine's polynomial has tables, so any other uses the bitwise reference
+    uint32_t crc                       = (poly == crc_engine.getPoly()) ? crc_engine.update(init, buf, len) :
+                                                                          tcpCrc32::updateBitwise(init, buf, len, poly);
+    return crc ^ 0xFFFFFFFF;
+}
 
-    uint32_t val;
-    uint32_t crc;
-    uint8_t i;
+// --------------------------------------------------
+// Checksum calculation for IPV4. Also used to
+// calculate TCP checksum, which includes parts of
+// IPV4 settings in a 'pseudo-header'
+// --------------------------------------------------
 
-    crc                                = init;
+uint32_t tcpIpPg::ipv4_chksum (const uint8_t* buf, uint32_t len, bool debug)
+{
+    uint32_t sum                       = tcpChksum::sum(buf, len);
 
-    while (len--)
+    if (debug)
     {
-        val                            = (crc ^ *buf++) & 0xFF;
-        for(i = 0; i < 8; i++)
-        {
-            val                        = (val & 1) ? (val >> 1) ^ poly : val >> 1;
-        }
-        crc                            = val ^ crc >> 8;
+        printf ("sum=0x%04x\n", sum);
     }
-    return crc ^ 0xFFFFFFFF;
+
+    return sum;
 }
 
 // --------------------------------------------------
-// Checksum calculation for IPV4. Also used to
-// calculate TCP checksum, which includes parts of
-// IPV4 settings in a 'pseudo-header'
+// Generate a TCP/IP packet. Parameters passed in
+// with cfg, and any data in payload (with payload
+// length). Data stored in frm_buf, which must be
+// sufficiently large to receive data. If the payload
+// is already at the frame buffer's payload offset
+// (see getPayloadPtr()) it is not copied.
 // --------------------------------------------------
 
-uint32_t tcpIpPg::ipv4_chksum (uint32_t* buf, uint32_t len, bool debug)
+uint32_t tcpIpPg::genTcpIpPkt (tcpConfig_t &cfg, uint8_t* frm_buf, const uint8_t* payload, uint32_t payload_len)
 {
-    uint32_t sum                       = 0;
+    uint8_t* frm_payload               = getPayloadPtr(frm_buf);
 
-    for (int idx = 0; idx < (len-1); idx+=2)
+    // Check that the payload fits in the ethernet frame before copying it into place
+    if (!payloadLenOk(payload_len))
     {
-        sum                            += ((buf[idx] & 0xff) << 8) | (buf[idx+1] & 0xff);
+        return 0;
+    }
 
-        if (debug)
-        {
-            printf ("sum=0x%04x word=0x%04x\n", sum, ((buf[idx] & 0xff) << 8) | (buf[idx+1] & 0xff));
-        }
+    if (payload_len && payload != frm_payload)
+    {
+        memmove(frm_payload, payload, payload_len);
     }
 
-    if (len & 1)
+    return genTcpIpPktInPlace(cfg, frm_buf, payload_len);
+}
+
+// --------------------------------------------------
+// Check that a TCP payload fits in the ethernet
+// frame, for the genTcpIpPkt() methods, reporting an
+// error if not
+// --------------------------------------------------
+
+bool tcpIpPg::payloadLenOk (uint32_t payload_len)
+{
+    if (payload_len > MAX_TCP_PAYLOAD)
     {
-        sum                            += (buf[len-1] & 0xff) << 8 ;
+        printf("NODE%d: genTcpIpPkt() : ***ERROR. Specified payload length (%d) too big. Must be <= %d\n",
+               node, payload_len, MAX_TCP_PAYLOAD);
+        return false;
     }
 
-    return sum;
+    return true;
 }
 
 // --------------------------------------------------
-// Generate a TCP/IP packet. Parameters passed in
-// with cfg, and any data in payload (with payload
-// length). Data stored in frm_buf, which must be
-// sufficiently large to receive data.
+// Generate a TCP/IP packet around a payload already
+// placed in frm_buf at FRAME_PAYLOAD_OFFSET. The
+// headers are written in place in front of the
+// payload, and checksums calculated over the frame's
+// final location.
 // --------------------------------------------------
 
-uint32_t tcpIpPg::genTcpIpPkt (tcpConfig_t &cfg, uint32_t* frm_buf, uint32_t* payload, uint32_t payload_len)
+uint32_t tcpIpPg::genTcpIpPktInPlace (tcpConfig_t &cfg, uint8_t* frm_buf, uint32_t payload_len)
 {
-    // Inetrmediate buffers for TCP and IPV4 data
-    uint32_t tcp_payload[2048];
-    uint32_t ipv4_payload[2048];
+    uint8_t* eth_payload               = &frm_buf[ETH_PREAMBLE + ETH_HDR_LEN];
+    uint8_t* ipv4_payload              = &eth_payload[IPV4_MIN_HDR_LEN*4];
 
-    // Construct a TCP segment and place in tcp_payoad. Returns total length of segment
-    uint32_t tcplen = tcpSegment(tcp_payload,
-                                 payload,
+    // Construct a TCP segment header in front of the payload. Returns total length of segment
+    uint32_t tcplen = tcpSegment(ipv4_payload,
                                  payload_len,
                                  cfg.dst_port,
                                  cfg.seq_num,
@@ -104,32 +126,73 @@ uint32_t tcpIpPg::genTcpIpPkt (tcpConfig_t &cfg, uint32_t* frm_buf, uint32_t* pa
                                  cfg.finish,
                                  cfg.win_size);
 
-    // Wrap TCP segment in an IPV4 frame, and add checksum to TCP (which includes pseudo-IP header).
-    // Data places in ipv4_payload and method returns total length.
-    uint32_t iplen  = ipv4Frame (ipv4_payload, tcp_payload, tcplen, cfg.ip_dst_addr);
+    // Add an IPV4 header in front of the TCP segment, and add checksum to TCP (which includes
+    // pseudo-IP header). Method returns total length.
+    uint32_t iplen  = ipv4Frame (eth_payload, tcplen, cfg.ip_dst_addr);
 
-    // Wrap IPV4 Frame in an ethernet frame, placing in frm_buf and returning total length of data
-    uint32_t flen   = ethFrame  (frm_buf, ipv4_payload, iplen, cfg.mac_dst_addr);
+    // Add the ethernet header, padding, CRC and delimiters around the IPV4 frame, returning
+    // total length of data
+    uint32_t flen   = ethFrame  (frm_buf, iplen, cfg.mac_dst_addr);
 
     // Return length of data in bytes.
     return flen;
 }
 
 // --------------------------------------------------
-// Construct TCP segment
+// Generate a TCP/IP packet with a payload and frame
+// buffer of one byte per word. The frame's start and
+// end delimiters have bit 8 set as control flags.
+// --------------------------------------------------
+
+uint32_t tcpIpPg::genTcpIpPkt (tcpConfig_t &cfg, uint32_t* frm_buf, uint32_t* payload, uint32_t payload_len)
+{
+    uint8_t  frame_bytes[ETH_MAX_FRAME_LEN];
+    uint8_t* frm_payload               = getPayloadPtr(frame_bytes);
+
+    if (!payloadLenOk(payload_len))
+    {
+        return 0;
+    }
+
+    // Pack the payload straight into its place in the frame
+    for (uint32_t idx = 0; idx < payload_len; idx++)
+    {
+        frm_payload[idx]               = payload[idx] & 0xff;
+    }
+
+    uint32_t flen                      = genTcpIpPktInPlace(cfg, frame_bytes, payload_len);
+
+    for (uint32_t idx = 0; idx < flen; idx++)
+    {
+        frm_buf[idx]                   = frame_bytes[idx];
+    }
+
+    // Flag the delimiters as control characters
+    if (flen)
+    {
+        frm_buf[0]                     |= CTRL_BIT;
+        frm_buf[flen-1]                |= CTRL_BIT;
+    }
+
+    return flen;
+}
+
+// --------------------------------------------------
+// Construct TCP segment header in front of a payload
+// of payload_len bytes already at TCP_MIN_HDR_LEN
+// DWORDS into tcp_seg.
 // -------------------------------------------------
 
-uint32_t tcpIpPg::tcpSegment (uint32_t* tcp_seg,
-                                uint32_t* payload,
-                                uint32_t  payload_len,
-                                uint32_t  dst_port,
-                                uint32_t  seq_num,
-                                uint32_t  ack_num,
-                                bool      ack,
-                                bool      reset_connection,
-                                bool      sync_seq,
-                                bool      finish,
-                                uint32_t  window_size)
+uint32_t tcpIpPg::tcpSegment (uint8_t*  tcp_seg,
+                              uint32_t  payload_len,
+                              uint32_t  dst_port,
+                              uint32_t  seq_num,
+                              uint32_t  ack_num,
+                              bool      ack,
+                              bool      reset_connection,
+                              bool      sync_seq,
+                              bool      finish,
+                              uint32_t  window_size)
 {
     // Initialise a frame index
     uint32_t fidx                      = 0;
@@ -168,7 +231,6 @@ uint32_t tcpIpPg::tcpSegment (uint32_t* tcp_seg,
     tcp_seg[fidx++]                    = window_size        & 0xff;
 
     // Blank checksum holder (need IP values for IP pseudo header before we can calculate, so postpone)
-    uint32_t chksum_offset             = fidx;
     tcp_seg[fidx++]                    = 0;
     tcp_seg[fidx++]                    = 0;
 
@@ -176,21 +238,17 @@ uint32_t tcpIpPg::tcpSegment (uint32_t* tcp_seg,
     tcp_seg[fidx++]                    = 0;
     tcp_seg[fidx++]                    = 0;
 
-    // Add payload (if any)
-    for (int idx = 0; idx < payload_len; idx++)
-    {
-        tcp_seg[fidx++]                = payload[idx] & 0xff;
-    }
-
-    // Return the length of the TCP segment
-    return fidx;
+    // Return the length of the TCP segment, including the payload
+    return fidx + payload_len;
 }
 
 // --------------------------------------------------
-// Construct IPv4 frame
+// Construct IPv4 header in front of a payload of
+// payload_len bytes already at IPV4_MIN_HDR_LEN
+// DWORDS into ipv4_frame.
 // --------------------------------------------------
 
-uint32_t tcpIpPg::ipv4Frame (uint32_t* ipv4_frame, uint32_t* payload, uint32_t payload_len, uint32_t ipv4_dst_addr, bool add_tcp_chksum)
+uint32_t tcpIpPg::ipv4Frame (uint8_t* ipv4_frame, uint32_t payload_len, uint32_t ipv4_dst_addr, bool add_tcp_chksum)
 {
     // Initialise a frame index
     uint32_t fidx                      = 0;
@@ -238,11 +296,14 @@ uint32_t tcpIpPg::ipv4Frame (uint32_t* ipv4_frame, uint32_t* payload, uint32_t p
         ipv4_frame[fidx++]             = ipv4_dst_addr >> 8*(3-idx);
     }
 
-    // Calculate basic checksum
-    uint32_t chksum                    = ipv4_chksum(ipv4_frame, fidx);
+    // Calculate basic checksum, and the one's complement checksum from it. If offloaded,
+    // the checksum is left zero.
+    uint32_t chksum                    = 0;
 
-    // One's complement checksum
-    chksum = ~((chksum & 0xffff) + (chksum >> 16)) & 0xffff;
+    if (offload.tx_ipv4_chksum)
+    {
+        chksum                         = tcpChksum::finish(ipv4_chksum(ipv4_frame, fidx));
+    }
 
     // Add the PIV4 checksum
     ipv4_frame[chksum_offset]          = chksum >> 8;
@@ -251,17 +312,12 @@ uint32_t tcpIpPg::ipv4Frame (uint32_t* ipv4_frame, uint32_t* payload, uint32_t p
     // Remember the offset where the payload begins
     uint32_t payload_offset            = fidx;
 
-    // Add any payload
-    for (int idx = 0; idx < payload_len; idx++)
+    // If requested, calculate and add the TCP checksum, based on TCP packet and IPV4 pseudo header.
+    // If offloaded, the checksum is left zero, or is just the (uninverted) pseudo header sum.
+    if (add_tcp_chksum && offload.tx_tcp_chksum != TX_TCP_CHKSUM_NONE)
     {
-        ipv4_frame[fidx++]             = payload[idx] & 0xff;
-    }
-
-    // If requested, calculate and add the TCP checksum, based on TCP packet and IPV4 pseudo header
-    if (add_tcp_chksum)
-    {
-        // Calculate the partial checksum for the TCP segment
-        uint32_t partial_chksum        = ipv4_chksum(&ipv4_frame[payload_offset], payload_len);
+        // Calculate the partial checksum for the TCP segment, in its final place
+        uint32_t partial_chksum        = (offload.tx_tcp_chksum == TX_TCP_CHKSUM_FULL) ? ipv4_chksum(&ipv4_frame[payload_offset], payload_len) : 0;
 
         // Calculate the rest of the checksum with the IP pseudo-header data
         partial_chksum                 += (ipv4_addr >> 16)     & 0xffff;
@@ -272,7 +328,8 @@ uint32_t tcpIpPg::ipv4Frame (uint32_t* ipv4_frame, uint32_t* payload, uint32_t p
         partial_chksum                 += (payload_len);
 
         // One's complement checksum
-        partial_chksum                 = ~((partial_chksum & 0xffff) + (partial_chksum >> 16)) & 0xffff;
+        partial_chksum                 = (offload.tx_tcp_chksum == TX_TCP_CHKSUM_FULL) ? tcpChksum::finish(partial_chksum) :
+                                                                                         tcpChksum::fold(partial_chksum);
 
         // Write TCP checksum to buffer
         ipv4_frame[payload_offset + TCP_CHKSUM_OFFSET]   = partial_chksum >> 8;
@@ -281,26 +338,28 @@ uint32_t tcpIpPg::ipv4Frame (uint32_t* ipv4_frame, uint32_t* payload, uint32_t p
     }
 
     // Return the length of the frame (in bytes)
-    return fidx;
+    return fidx + payload_len;
 }
 
 // --------------------------------------------------
-// Construct ethernet frame
+// Construct ethernet frame around a payload of
+// payload_len bytes already at ETH_PREAMBLE +
+// ETH_HDR_LEN bytes into frame.
 // --------------------------------------------------
 
-uint32_t tcpIpPg::ethFrame(uint32_t* frame, uint32_t* payload, uint32_t payload_len, uint64_t dst_addr)
+uint32_t tcpIpPg::ethFrame(uint8_t* frame, uint32_t payload_len, uint64_t dst_addr)
 {
     uint32_t fidx                      = 0;
 
     // Check that any payload can fit in an ethernet packet
-    if (payload_len > 1500)
+    if (payload_len > ETH_MTU)
     {
-        printf("NODE%d: ethFrame() : ***ERROR. Specified payload length (%d) too big. Must be <= 1500\n", node, payload_len);
+        printf("NODE%d: ethFrame() : ***ERROR. Specified payload length (%d) too big. Must be <= %d\n", node, payload_len, ETH_MTU);
         return 0;
     }
 
     // Add a start-of-frame token
-    frame[fidx++]                      = SOF;
+    frame[fidx++]                      = SOF & 0xff;
 
     // Add 7 bytes of preamble
     for (int idx = 0; idx < ETH_PREAMBLE-2; idx++)
@@ -327,19 +386,26 @@ uint32_t tcpIpPg::ethFrame(uint32_t* frame, uint32_t* payload, uint32_t payload_
     frame[fidx++]                      = 0x08;
     frame[fidx++]                      = 0x00;
 
-    // Add the payload
-    for (int idx = 0; idx < payload_len; idx++)
-    {
-        frame[fidx++]                  = payload[idx] & 0xff;
-    }
+    // Add padding, CRC and EOF after the payload, returning total length
+    return ethFrameTail(frame, payload_len);
+}
+
+// --------------------------------------------------
+// Add padding, CRC and end of frame delimiter to an
+// ethernet frame with its headers and payload in
+// place
+// --------------------------------------------------
+
+uint32_t tcpIpPg::ethFrameTail(uint8_t* frame, uint32_t payload_len)
+{
+    // Index just after the payload
+    uint32_t fidx                      = ETH_PREAMBLE + ETH_HDR_LEN + payload_len;
 
     // If the payload runs short of the 64 byte minimum size then pad
-    if (payload_len < 46)
+    if (payload_len < ETH_MIN_PAYLOAD)
     {
-        for (int idx = 0; idx < (46 - payload_len); idx++)
-        {
-            frame[fidx++]              = 0;
-        }
+        memset(&frame[fidx], 0, ETH_MIN_PAYLOAD - payload_len);
+        fidx                           += ETH_MIN_PAYLOAD - payload_len;
     }
 
     // Calculate the CRC (excluding SOF, SFD and preamble)
@@ -352,182 +418,646 @@ uint32_t tcpIpPg::ethFrame(uint32_t* frame, uint32_t* payload, uint32_t payload_
     }
 
     // Add the EOF delimiter
-    frame[fidx++]                      = EoF;
+    frame[fidx++]                      = EoF & 0xff;
 
     // Return the length of the ethernet data (in bytes), including preamble
     return fidx;
 
 }
 
+// --------------------------------------------------
+// Initialise a flow template with the fixed header
+// fields for a connection. Fields that change per
+// packet are left zero and excluded from the partial
+// checksums.
+// --------------------------------------------------
+
+void tcpIpPg::initFlowTemplate (tcpFlowTemplate_t &tmpl, tcpConfig_t &cfg, uint32_t src_port)
+{
+    uint8_t* eth_payload               = &tmpl.hdr[ETH_PREAMBLE + ETH_HDR_LEN];
+    uint8_t* tcp_hdr                   = &eth_payload[IPV4_MIN_HDR_LEN*4];
+
+    // Form the TCP header with zero seq, ack, flags and window, and an IPv4 header for an empty segment,
+    // without TCP checksum
+    tcpSegment(tcp_hdr, 0, cfg.dst_port, 0, 0, false, false, false, false, 0);
+    tcp_hdr[0]                         = (src_port >> 8) & 0xff;
+    tcp_hdr[1]                         = src_port & 0xff;
+    ipv4Frame(eth_payload, TCP_MIN_HDR_LEN*4, cfg.ip_dst_addr, false);
+
+    // Add the ethernet header (the tail is written beyond the template and so is discarded)
+    uint8_t  frame[ETH_MAX_FRAME_LEN];
+    memcpy(&frame[ETH_PREAMBLE + ETH_HDR_LEN], eth_payload, (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4);
+    ethFrame(frame, (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4, cfg.mac_dst_addr);
+    memcpy(tmpl.hdr, frame, ETH_PREAMBLE + ETH_HDR_LEN);
+
+    // IPv4 checksum for the template's total length, calculated over the header with a zero
+    // checksum field, so it is available whether or not the checksum generation is offloaded
+    eth_payload[IPV4_CHKSUM_OFFSET]    = 0;
+    eth_payload[IPV4_CHKSUM_OFFSET+1]  = 0;
+    tmpl.ipv4_chksum                   = tcpChksum::finish(ipv4_chksum(eth_payload, IPV4_MIN_HDR_LEN*4));
+
+    // Partial TCP checksum of the fixed header fields (ports, data offset and urgent pointer)
+    // and the pseudo-header addresses and protocol
+    tmpl.tcp_pseudo                    = (ipv4_addr >> 16)       & 0xffff;
+    tmpl.tcp_pseudo                    += (ipv4_addr >>  0)       & 0xffff;
+    tmpl.tcp_pseudo                    += (cfg.ip_dst_addr >> 16) & 0xffff;
+    tmpl.tcp_pseudo                    += (cfg.ip_dst_addr >>  0) & 0xffff;
+    tmpl.tcp_pseudo                    += (TCP_PROTOCOL_NUM);
+    tmpl.tcp_partial                   = ipv4_chksum(tcp_hdr, TCP_MIN_HDR_LEN*4) + tmpl.tcp_pseudo;
+}
+
+// --------------------------------------------------
+// Generate a TCP/IP packet from a flow template. The
+// template header is copied in front of the payload
+// and only the per-packet fields patched, with the
+// IPv4 checksum incrementally updated (RFC 1624) for
+// the new length and the TCP checksum completed from
+// the template's partial sum.
+// --------------------------------------------------
+
+uint32_t tcpIpPg::genTcpIpPkt (tcpFlowTemplate_t &tmpl, tcpConfig_t &cfg, uint8_t* frm_buf, uint32_t payload_len)
+{
+    uint8_t* ipv4_hdr                  = &frm_buf[ETH_PREAMBLE + ETH_HDR_LEN];
+    uint8_t* tcp_hdr                   = &ipv4_hdr[IPV4_MIN_HDR_LEN*4];
+
+    uint32_t tcp_len                   = TCP_MIN_HDR_LEN*4 + payload_len;
+    uint32_t total_len                 = IPV4_MIN_HDR_LEN*4 + tcp_len;
+    uint32_t flags                     = (cfg.ack      ? TCP_FLAG_ACK : 0) |
+                                         (cfg.rst_conn ? TCP_FLAG_RST : 0) |
+                                         (cfg.sync_seq ? TCP_FLAG_SYN : 0) |
+                                         (cfg.finish   ? TCP_FLAG_FIN : 0);
+
+    if (!payloadLenOk(payload_len))
+    {
+        return 0;
+    }
+
+    memcpy(frm_buf, tmpl.hdr, FRAME_PAYLOAD_OFFSET);
+
+    // Patch the IPv4 total length and update its checksum (left zero if offloaded)
+    uint32_t ipv4_chksum_val           = offload.tx_ipv4_chksum ? tcpChksum::update(tmpl.ipv4_chksum, (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4, total_len) : 0;
+
+    ipv4_hdr[2]                        = total_len >> 8;
+    ipv4_hdr[3]                        = total_len & 0xff;
+    ipv4_hdr[IPV4_CHKSUM_OFFSET]       = ipv4_chksum_val >> 8;
+    ipv4_hdr[IPV4_CHKSUM_OFFSET+1]     = ipv4_chksum_val & 0xff;
+
+    // Patch the TCP sequence and acknowledge numbers, flags and window
+    tcp_hdr[4]                         = cfg.seq_num >> 24;
+    tcp_hdr[5]                         = cfg.seq_num >> 16;
+    tcp_hdr[6]                         = cfg.seq_num >>  8;
+    tcp_hdr[7]                         = cfg.seq_num;
+    tcp_hdr[8]                         = cfg.ack_num >> 24;
+    tcp_hdr[9]                         = cfg.ack_num >> 16;
+    tcp_hdr[10]                        = cfg.ack_num >>  8;
+    tcp_hdr[11]                        = cfg.ack_num;
+    tcp_hdr[13]                        = flags;
+    tcp_hdr[14]                        = cfg.win_size >> 8;
+    tcp_hdr[15]                        = cfg.win_size;
+
+    // Complete the TCP checksum with the patched fields, the pseudo-header length and the payload.
+    // If offloaded, the checksum is left zero, or is just the (uninverted) pseudo header sum.
+    uint32_t tcp_chksum_val            = 0;
+
+    if (offload.tx_tcp_chksum == TX_TCP_CHKSUM_FULL)
+    {
+        uint64_t tcp_sum               = (uint64_t)tmpl.tcp_partial +
+                                         (cfg.seq_num >> 16) + (cfg.seq_num & 0xffff) +
+                                         (cfg.ack_num >> 16) + (cfg.ack_num & 0xffff) +
+                                         flags + (cfg.win_size & 0xffff) + tcp_len;
+
+        tcp_chksum_val                 = tcpChksum::finish(tcpChksum::sum(&tcp_hdr[TCP_MIN_HDR_LEN*4], payload_len, tcpChksum::fold(tcp_sum)));
+    }
+    else if (offload.tx_tcp_chksum == TX_TCP_CHKSUM_PARTIAL)
+    {
+        tcp_chksum_val                 = tcpChksum::fold(tmpl.tcp_pseudo + tcp_len);
+    }
+
+    tcp_hdr[TCP_CHKSUM_OFFSET]         = tcp_chksum_val >> 8;
+    tcp_hdr[TCP_CHKSUM_OFFSET+1]       = tcp_chksum_val & 0xff;
+
+    // Add padding, CRC and EOF
+    return ethFrameTail(frm_buf, total_len);
+}
+
+// --------------------------------------------------
+// Generate a batch of TCP/IP packets from a large
+// payload, cut into MSS sized segments, into a ring
+// of frame slots. All segments share a flow template
+// built from cfg.
+// --------------------------------------------------
+
+uint32_t tcpIpPg::genTcpIpPktBatch (tcpConfig_t &cfg, const uint8_t* payload, uint32_t total_len, uint32_t mss, tcpFrameRing &out_ring)
+{
+    tcpFlowTemplate_t tmpl;
+    uint32_t          offset           = 0;
+    uint32_t          max_seg          = MAX_TCP_PAYLOAD;
+
+    if (out_ring.slotSize() < ETH_MAX_FRAME_LEN)
+    {
+        printf("NODE%d: genTcpIpPktBatch() : ***ERROR. Ring slot size (%d) too small. Must be >= %d\n",
+               node, out_ring.slotSize(), ETH_MAX_FRAME_LEN);
+        return 0;
+    }
+
+    // Limit the segment size to what will fit in an ethernet frame
+    mss                                = (mss == 0 || mss > max_seg) ? max_seg : mss;
+
+    initFlowTemplate(tmpl, cfg);
+
+    while (offset < total_len && !out_ring.full())
+    {
+        uint32_t seg_len               = (total_len - offset < mss) ? total_len - offset : mss;
+        uint8_t* frm_buf               = out_ring.nextFree();
+
+        memcpy(getPayloadPtr(frm_buf), &payload[offset], seg_len);
+
+        out_ring.push(genTcpIpPkt(tmpl, cfg, frm_buf, seg_len));
+
+        cfg.seq_num                    += seg_len;
+        offset                         += seg_len;
+    }
+
+    return offset;
+}
+
+// --------------------------------------------------
+// Send the frames queued in a ring, at the rate of
+// the node's and any flow's shapers
+// --------------------------------------------------
+
+uint32_t tcpIpPg::sendFrames (tcpFrameRing &ring, tcpShaper* flow_shaper, bool wait)
+{
+    uint32_t sent                      = 0;
+
+    while (!ring.empty())
+    {
+        uint32_t len;
+        uint8_t* frm_buf               = ring.front(len);
+
+        if (flow_shaper != NULL)
+        {
+            if (!wait && flow_shaper->delay(TcpVpGetTicks(), TcpVpWireBytes(len)))
+            {
+                break;
+            }
+
+            TcpVpShapeFrame(*flow_shaper, len);
+        }
+
+        TcpVpSendRawEthFrame(frm_buf, len);
+
+        ring.pop();
+        sent++;
+    }
+
+    return sent;
+}
+
 // --------------------------------------------------
 // Process the received frames
 // --------------------------------------------------
 
-uint32_t tcpIpPg::processFrame (uint32_t* rx_data, uint32_t rx_len)
+uint32_t tcpIpPg::processFrame (const uint8_t* rx_data, uint32_t rx_len)
 {
-    uint32_t error                     = 0;
+    rxHdr_t  rxHdr;
 
-    rxInfo_t rxInfo;
+    // A frame too short to hold the headers and CRC can't have a good CRC
+    if (rx_len < ETH_HDR_LEN + (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4 + ETH_CRC_LEN)
+    {
+        return rxDrop(RX_BAD_CRC);
+    }
+
+    const uint8_t* ipv4_hdr            = &rx_data[ETH_HDR_LEN];
+    const uint8_t* tcp_hdr             = &ipv4_hdr[IPV4_MIN_HDR_LEN*4];
 
     // -------------------------
-    // MAC
+    // Address filters
     // -------------------------
 
-    // Check frame's CRC
-    uint32_t crc                       = crc32(rx_data, rx_len-4);
-    uint32_t pktcrc                    = rx_data[rx_len-1] << 24 |
-                                         rx_data[rx_len-2] << 16 |
-                                         rx_data[rx_len-3] <<  8 |
-                                         rx_data[rx_len-4] <<  0 ;
+    // Check that the frame is addressed to us, at each layer, before paying for any
+    // integrity checks over the whole frame
+
+    // Check that the MAC address is for us
+    uint64_t dst_mac_addr              = loadBe64(&rx_data[0]) >> 16;
 
-    if (crc != pktcrc)
+    if (dst_mac_addr != mac_addr)
     {
-        error                          |= RX_BAD_CRC;
-        printf("WARNING: bad MAC CRC on received packet\n");
-        return error;
+        return rxDrop(RX_WRONG_MAC_ADDR);
     }
 
-    // Check that the MAC address is for us
-    uint32_t ridx = 0;
-    uint64_t dst_mac_addr              = (uint64_t)rx_data[ridx++] << 40 |
-                                         (uint64_t)rx_data[ridx++] << 32 |
-                                         (uint64_t)rx_data[ridx++] << 24 |
-                                         (uint64_t)rx_data[ridx++] << 16 |
-                                         (uint64_t)rx_data[ridx++] <<  8 |
-                                         (uint64_t)rx_data[ridx++];
+    uint32_t ipv4_dst_addr             = loadBe32(&ipv4_hdr[IPV4_DST_ADDR_OFFSET*4]);
 
-    if (dst_mac_addr != mac_addr)
+    if (ipv4_dst_addr != ipv4_addr)
+    {
+        return rxDrop(RX_WRONG_IPV4_ADDR);
+    }
+
+    uint32_t tcp_dst_port              = loadBe16(&tcp_hdr[2]);
+
+    // Look up the frame's flow, if any have been added, for a port other than the node's
+    // port or for callbacks other than the node's
+    flow_t*  flow                      = NULL;
+
+    if (!flows.empty())
     {
-        error                          |= 1; // Incorrect MAC addr
-        printf("WARNING: non-matching MAC address on received packet\n");
-        return error;
+        flow                           = flows.find(flowKey(loadBe32(&ipv4_hdr[IPV4_SRC_ADDR_OFFSET*4]),
+                                                            loadBe16(&tcp_hdr[0]), tcp_dst_port));
     }
 
-    // Extract SRC addr
-    rxInfo.mac_src_addr                = (uint64_t)rx_data[ridx++] << 40 |
-                                         (uint64_t)rx_data[ridx++] << 32 |
-                                         (uint64_t)rx_data[ridx++] << 24 |
-                                         (uint64_t)rx_data[ridx++] << 16 |
-                                         (uint64_t)rx_data[ridx++] <<  8 |
-                                         (uint64_t)rx_data[ridx++];
+    if (flow == NULL && tcp_dst_port != tcp_port)
+    {
+        return rxDrop(RX_WRONG_TCP_PORT);
+    }
 
     // -------------------------
-    // IPV4
+    // Integrity checks
     // -------------------------
 
-    // Check IP header for integrity and addressed to us and, if so, save src address
-    uint32_t chksum                    = ipv4_chksum(&rx_data[ETH_HDR_LEN], IPV4_MIN_HDR_LEN*4);
-    chksum                             = ~((chksum & 0xffff) + (chksum >> 16)) & 0xffff;
+    // Length of the TCP segment, limited to the bytes actually received. An IPv4 total
+    // length not matching the frame is a malformed IPv4 header.
+    uint32_t total_len                 = loadBe16(&ipv4_hdr[2]);
+    uint32_t ipv4_payload_len          = total_len - IPV4_MIN_HDR_LEN*4;
+    uint32_t tcp_avail_len             = rx_len - ETH_CRC_LEN - (uint32_t)(tcp_hdr - rx_data);
+    bool     seg_len_bad               = total_len < (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4 || ipv4_payload_len > tcp_avail_len;
+    uint32_t seg_len                   = seg_len_bad ? tcp_avail_len : ipv4_payload_len;
+
+    // Checks not skipped by the offload settings
+    bool     check_crc                 = !(offload.rx_skip_checks & RX_BAD_CRC);
+    bool     check_tcp                 = !(offload.rx_skip_checks & RX_BAD_TCP_CHECKSUM);
 
-    if (chksum)
+    uint32_t crc                       = 0;
+    uint32_t partial_chksum            = 0;
+
+    if (check_crc && check_tcp)
     {
-        error |= RX_BAD_IPV4_CHECKSUM;
-        printf("WARNING: bad IPV4 checksum on received packet\n");
-        return error;
+        // CRC over the headers, then the CRC and TCP checksum together, a block at a time,
+        // over the segment, then the CRC over any padding
+        crc                            = crc_engine.update(INIT, rx_data, (uint32_t)(tcp_hdr - rx_data));
+
+        for (uint32_t offset = 0; offset < seg_len; offset += RX_CHECK_BLOCK_LEN)
+        {
+            uint32_t blk_len           = (seg_len - offset > RX_CHECK_BLOCK_LEN) ? RX_CHECK_BLOCK_LEN : seg_len - offset;
+
+            crc                        = crc_engine.update(crc, &tcp_hdr[offset], blk_len);
+            partial_chksum             = tcpChksum::sum(&tcp_hdr[offset], blk_len, partial_chksum);
+        }
+
+        crc                            = crc_engine.update(crc, &tcp_hdr[seg_len], tcp_avail_len - seg_len) ^ 0xFFFFFFFF;
+    }
+    else if (check_crc)
+    {
+        crc                            = crc_engine.update(INIT, rx_data, rx_len - ETH_CRC_LEN) ^ 0xFFFFFFFF;
+    }
+    else if (check_tcp)
+    {
+        partial_chksum                 = tcpChksum::sum(tcp_hdr, seg_len);
     }
 
-    uint32_t total_len                 =  (rx_data[ETH_HDR_LEN+2] << 8) |
-                                          (rx_data[ETH_HDR_LEN+3]);
+    // Check frame's CRC
+    if (check_crc && crc != loadLe32(&rx_data[rx_len-ETH_CRC_LEN]))
+    {
+        return rxDrop(RX_BAD_CRC);
+    }
 
-    uint32_t ipv4_payload_len          = total_len - IPV4_MIN_HDR_LEN*4;
+    // Check IP header for integrity
+    if (!(offload.rx_skip_checks & RX_BAD_IPV4_CHECKSUM) && tcpChksum::finish(ipv4_chksum(ipv4_hdr, IPV4_MIN_HDR_LEN*4)))
+    {
+        return rxDrop(RX_BAD_IPV4_CHECKSUM);
+    }
 
-    ridx                               = ETH_HDR_LEN + IPV4_SRC_ADDR_OFFSET*4;
+    // A bad IPv4 total length is dropped with the IPv4 header errors, even with the IPv4
+    // checksum check skipped, so as not to be counted as a bad TCP checksum
+    if (seg_len_bad)
+    {
+        return rxDrop(RX_BAD_IPV4_CHECKSUM);
+    }
 
-    rxInfo.ipv4_src_addr               = rx_data[ridx++] << 24 |
-                                         rx_data[ridx++] << 16 |
-                                         rx_data[ridx++] <<  8 |
-                                         rx_data[ridx++];
+    rxHdr.ipv4_src_addr                = loadBe32(&ipv4_hdr[IPV4_SRC_ADDR_OFFSET*4]);
 
-    uint32_t ipv4_dst_addr             = rx_data[ridx++] << 24 |
-                                         rx_data[ridx++] << 16 |
-                                         rx_data[ridx++] <<  8 |
-                                         rx_data[ridx++];
+    // Calculate the rest of the TCP checksum with the IP pseudo-header data
+    if (check_tcp)
+    {
+        partial_chksum                 += (rxHdr.ipv4_src_addr >> 16) & 0xffff;
+        partial_chksum                 += (rxHdr.ipv4_src_addr >>  0) & 0xffff;
+        partial_chksum                 += (ipv4_dst_addr >> 16)     & 0xffff;
+        partial_chksum                 += (ipv4_dst_addr >>  0)     & 0xffff;
+        partial_chksum                 += (TCP_PROTOCOL_NUM);
+        partial_chksum                 += (ipv4_payload_len);
 
-    if (ipv4_dst_addr != ipv4_addr)
+        // One's complement checksum
+        partial_chksum                 = tcpChksum::finish(partial_chksum);
+    }
+
+    uint32_t data_off_bytes            = (tcp_hdr[12] >> 4) * 4;
+
+    // A TCP data offset beyond the segment is a TCP header error, always checked
+    if (partial_chksum || data_off_bytes > seg_len)
     {
-        error                          |= RX_WRONG_IPV4_ADDR;
-        printf("WARNING: non-matching IPV4 address on received packet\n");
-        return error;
+        return rxDrop(RX_BAD_TCP_CHECKSUM);
     }
 
     // -------------------------
-    // TCP
+    // Extract header fields
     // -------------------------
 
-    // Check TCP segment integrity and correct port. Save src port #,  src seq and ack#, winsize
+    rxHdr.mac_src_addr                 = loadBe64(&rx_data[6]) >> 16;
+    rxHdr.tcp_src_port                 = loadBe16(&tcp_hdr[0]);
+    rxHdr.tcp_dst_port                 = tcp_dst_port;
+    rxHdr.tcp_seq_num                  = loadBe32(&tcp_hdr[4]);
+    rxHdr.tcp_ack_num                  = loadBe32(&tcp_hdr[8]);
+    rxHdr.tcp_flags                    = loadBe16(&tcp_hdr[12]) & 0x1ff;
+    rxHdr.tcp_win_size                 = loadBe16(&tcp_hdr[14]);
+
+    // Payload follows the TCP header, including any options
+    uint32_t ridx                      = (uint32_t)(tcp_hdr - rx_data) + data_off_bytes;
+
+    // If all checks out, pass a view of the frame to the user view callback, if one registered
+    rxView_t rxView;
+    rxView.frame                       = rx_data;
+    rxView.frame_len                   = rx_len;
+    rxView.payload                     = &rx_data[ridx];
+    rxView.payload_len                 = ipv4_payload_len-data_off_bytes;
+
+    // Count the accepted frame
+    rx_counts[RX_CNT_FRAMES].fetch_add(1, std::memory_order_relaxed);
+    rx_counts[RX_CNT_BYTES].fetch_add(rx_len, std::memory_order_relaxed);
+    rx_counts[RX_CNT_PAYLOAD].fetch_add(rxView.payload_len, std::memory_order_relaxed);
+
+    // A frame for a flow goes to the flow's callbacks, else to the node's. They're selected
+    // before calling either, in case the view callback removes the flow.
+    pUsrRxViewCbFunc_t view_func       = usrRxViewCbFunc;
+    pUsrRxCbFunc_t     rx_func         = usrRxCbFunc;
+    void*              rx_view_hdl     = view_hdl;
+    void*              rx_hdl          = hdl;
+
+    if (flow != NULL)
+    {
+        flow->frames++;
+        flow->payload_bytes            += rxView.payload_len;
+
+        view_func                      = flow->rx_view_func;
+        rx_func                        = flow->rx_func;
+        rx_view_hdl                    = flow->hdl;
+        rx_hdl                         = flow->hdl;
+    }
+
+    if (view_func != NULL)
+    {
+        (*view_func)(&rxHdr, &rxView, rx_view_hdl);
+    }
+
+    // If all checks out, extract payload and call usr callback, if one registered
+    if (rx_func != NULL)
+    {
+        rxInfo_t rxInfo;
+
+        rxInfo.mac_src_addr            = rxHdr.mac_src_addr;
+        rxInfo.ipv4_src_addr           = rxHdr.ipv4_src_addr;
+        rxInfo.tcp_src_port            = rxHdr.tcp_src_port;
+        rxInfo.tcp_seq_num             = rxHdr.tcp_seq_num;
+        rxInfo.tcp_ack_num             = rxHdr.tcp_ack_num;
+        rxInfo.tcp_flags               = rxHdr.tcp_flags;
+        rxInfo.tcp_win_size            = rxHdr.tcp_win_size;
+        rxInfo.rx_len                  = (rxView.payload_len > ETH_MTU) ? ETH_MTU : rxView.payload_len;
+
+        memcpy(rxInfo.rx_payload, rxView.payload, rxInfo.rx_len);
+
+        (*rx_func)(rxInfo, rx_hdl);
+    }
+
+    return 0;
 
-    // Calculate the partial checksum for the TCP segment
-    uint32_t partial_chksum            = ipv4_chksum(&rx_data[ridx], ipv4_payload_len);
+}
 
-    // Calculate the rest of the checksum with the IP pseudo-header data
-    partial_chksum                     += (rxInfo.ipv4_src_addr >> 16) & 0xffff;
-    partial_chksum                     += (rxInfo.ipv4_src_addr >>  0) & 0xffff;
-    partial_chksum                     += (ipv4_dst_addr >> 16)     & 0xffff;
-    partial_chksum                     += (ipv4_dst_addr >>  0)     & 0xffff;
-    partial_chksum                     += (TCP_PROTOCOL_NUM);
-    partial_chksum                     += (ipv4_payload_len);
+// --------------------------------------------------
+// Add a flow to the receive path's flow table
+// --------------------------------------------------
 
-    // One's complement checksum
-    partial_chksum                     = ~((partial_chksum & 0xffff) + (partial_chksum >> 16)) & 0xffff;
+bool tcpIpPg::addFlow (uint32_t           remote_addr,
+                       uint32_t           remote_port,
+                       uint32_t           local_port,
+                       pUsrRxCbFunc_t     pFunc,
+                       void*              hdlIn,
+                       pUsrRxViewCbFunc_t pViewFunc)
+{
+    flow_t flow;
 
-    if (partial_chksum)
+    flow.rx_func                       = pFunc;
+    flow.rx_view_func                  = pViewFunc;
+    flow.hdl                           = hdlIn;
+    flow.frames                        = 0;
+    flow.payload_bytes                 = 0;
+
+    if (flows.size() == flows.maxFlows())
     {
-        error                          |= RX_BAD_TCP_CHECKSUM;
-        printf("WARNING: bad TCP checksum on received packet\n");
-        return error;
+        printf("NODE%d: addFlow() : ***ERROR. Flow table full (%d flows)\n", node, flows.maxFlows());
+        return false;
     }
 
+    if (flows.add(flowKey(remote_addr, remote_port, local_port), flow) == NULL)
+    {
+        printf("NODE%d: addFlow() : ***ERROR. Flow from %08x:%d to port %d already added\n",
+               node, remote_addr, remote_port, local_port);
+        return false;
+    }
 
-    // Extract TCP info
-    rxInfo.tcp_src_port                = rx_data[ridx++] << 8 |
-                                         rx_data[ridx++];
+    return true;
+}
 
-    uint32_t tcp_dst_port              = rx_data[ridx++] << 8 |
-                                         rx_data[ridx++];
+// --------------------------------------------------
+// Set the size of the receive path's flow table
+// --------------------------------------------------
 
-    if (tcp_dst_port != tcp_port)
+bool tcpIpPg::setMaxFlows (uint32_t max_flows)
+{
+    if (!flows.setMaxFlows(max_flows))
     {
-        error                          |= RX_WRONG_TCP_PORT;
-        printf("WARNING: non-matching TCP port number on received packet\n");
-        return error;
+        printf("NODE%d: setMaxFlows() : ***ERROR. Flows already added (%d flows)\n", node, flows.size());
+        return false;
     }
 
-    rxInfo.tcp_seq_num                 = rx_data[ridx++] << 24 |
-                                         rx_data[ridx++] << 16 |
-                                         rx_data[ridx++] <<  8 |
-                                         rx_data[ridx++];
+    return true;
+}
 
-    rxInfo.tcp_ack_num                 = rx_data[ridx++] << 24 |
-                                         rx_data[ridx++] << 16 |
-                                         rx_data[ridx++] <<  8 |
-                                         rx_data[ridx++];
+// --------------------------------------------------
+// Remove a flow from the receive path's flow table
+// --------------------------------------------------
 
-    uint32_t data_off_bytes            = (rx_data[ridx] >> 4) * 4;
+bool tcpIpPg::removeFlow (uint32_t remote_addr, uint32_t remote_port, uint32_t local_port)
+{
+    return flows.remove(flowKey(remote_addr, remote_port, local_port));
+}
 
-    rxInfo.tcp_flags                   = (rx_data[ridx++] & 0x01) << 8 |
-                                         rx_data[ridx++];
+// --------------------------------------------------
+// Get a flow's receive state
+// --------------------------------------------------
+
+const tcpIpPg::flow_t* tcpIpPg::getFlow (uint32_t remote_addr, uint32_t remote_port, uint32_t local_port)
+{
+    return flows.find(flowKey(remote_addr, remote_port, local_port));
+}
 
-    rxInfo.tcp_win_size                = rx_data[ridx++] <<  8 |
-                                         rx_data[ridx++];
+// --------------------------------------------------
+// Count a dropped frame against its error type, and
+// log it according to the logging mode. Returns the
+// error mask.
+// --------------------------------------------------
 
-    // Skip over next DWORDS (checksum and urgent pointer)
-    ridx                               += 4;
+uint32_t tcpIpPg::rxDrop (uint32_t error)
+{
+    static const char* err_str[RX_NUM_ERR_TYPES] = {"bad MAC CRC",
+                                                    "non-matching MAC address",
+                                                    "bad IPV4 checksum",
+                                                    "non-matching IPV4 address",
+                                                    "bad TCP checksum",
+                                                    "non-matching TCP port number"};
+
+    // Error masks are single bits, in the order of the counters
+    uint32_t err_idx                   = 0;
+    while ((error >> err_idx) > 1)
+    {
+        err_idx++;
+    }
 
-    // Skip over any extra bytes specified beyond the minimum
-    ridx                               += data_off_bytes - IPV4_MIN_HDR_LEN*4;
+    uint64_t count                     = rx_counts[err_idx].fetch_add(1, std::memory_order_relaxed) + 1;
 
-    // If all checks out, extract payload and call usr callback, if one registered
-    if (!error && usrRxCbFunc != NULL)
+    switch (rx_log_mode)
     {
-        rxInfo.rx_len                  = ipv4_payload_len-data_off_bytes;
+    case RX_LOG_ALL:
+        printf("WARNING: %s on received packet\n", err_str[err_idx]);
+        break;
 
-        for(int idx = 0; idx < rxInfo.rx_len; idx++)
+    // Log only the 1st, 2nd, 4th, 8th etc. of each type
+    case RX_LOG_RATE_LIMITED:
+        if ((count & (count - 1)) == 0)
         {
-            rxInfo.rx_payload[idx]     = rx_data[ridx++];
+            printf("NODE%d: WARNING: %s on received packet (%llu so far)\n", node, err_str[err_idx], (unsigned long long)count);
         }
-        (*usrRxCbFunc)(rxInfo, hdl);
+        break;
+
+    default:
+        break;
     }
 
     return error;
+}
+
+// --------------------------------------------------
+// Get a snapshot of the receive counts
+// --------------------------------------------------
 
-}
\ No newline at end of file
+tcpIpPg::rxStats_t tcpIpPg::getStats (void)
+{
+    rxStats_t stats;
+
+    stats.bad_crc                      = rx_counts[RX_CNT_CRC].load(std::memory_order_relaxed);
+    stats.wrong_mac_addr               = rx_counts[RX_CNT_MAC_ADDR].load(std::memory_order_relaxed);
+    stats.bad_ipv4_chksum              = rx_counts[RX_CNT_IPV4_CHKSUM].load(std::memory_order_relaxed);
+    stats.wrong_ipv4_addr              = rx_counts[RX_CNT_IPV4_ADDR].load(std::memory_order_relaxed);
+    stats.bad_tcp_chksum               = rx_counts[RX_CNT_TCP_CHKSUM].load(std::memory_order_relaxed);
+    stats.wrong_tcp_port               = rx_counts[RX_CNT_TCP_PORT].load(std::memory_order_relaxed);
+    stats.frames                       = rx_counts[RX_CNT_FRAMES].load(std::memory_order_relaxed);
+    stats.bytes                        = rx_counts[RX_CNT_BYTES].load(std::memory_order_relaxed);
+    stats.payload_bytes                = rx_counts[RX_CNT_PAYLOAD].load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+// --------------------------------------------------
+// Clear the receive counts
+// --------------------------------------------------
+
+void tcpIpPg::resetStats (void)
+{
+    for (uint32_t idx = 0; idx < RX_NUM_COUNTS; idx++)
+    {
+        rx_counts[idx].store(0, std::memory_order_relaxed);
+    }
+}
+
+// --------------------------------------------------
+// Display the receive counts
+// --------------------------------------------------
+
+void tcpIpPg::printStats (void)
+{
+    rxStats_t stats                    = getStats();
+
+    printf("NODE%d: received %llu frames (%llu bytes, %llu payload bytes)\n", node,
+           (unsigned long long)stats.frames, (unsigned long long)stats.bytes, (unsigned long long)stats.payload_bytes);
+    printf("NODE%d: dropped  %llu bad CRC, %llu wrong MAC addr, %llu bad IPV4 checksum, %llu wrong IPV4 addr, %llu bad TCP checksum, %llu wrong TCP port\n", node,
+           (unsigned long long)stats.bad_crc,        (unsigned long long)stats.wrong_mac_addr,
+           (unsigned long long)stats.bad_ipv4_chksum, (unsigned long long)stats.wrong_ipv4_addr,
+           (unsigned long long)stats.bad_tcp_chksum,  (unsigned long long)stats.wrong_tcp_port);
+}
+// --------------------------------------------------
+// Keep a received frame by copying it into a pooled
+// buffer of the smallest size that fits
+// --------------------------------------------------
+
+bool tcpIpPg::keepFrame (const rxHdr_t* rx_hdr, const rxView_t* rx_view, rxFrame_t &kept)
+{
+    if (!rx_pool.alloc(rx_view->frame_len, kept.pkt))
+    {
+        printf("NODE%d: keepFrame() : ***ERROR. No free buffers to keep received frame of %d bytes\n", node, rx_view->frame_len);
+        return false;
+    }
+
+    memcpy(kept.pkt.buf, rx_view->frame, rx_view->frame_len);
+
+    kept.hdr                           = *rx_hdr;
+    kept.view.frame                    = kept.pkt.buf;
+    kept.view.frame_len                = rx_view->frame_len;
+    kept.view.payload                  = kept.pkt.buf + (rx_view->payload - rx_view->frame);
+    kept.view.payload_len              = rx_view->payload_len;
+
+    return true;
+}
+
+// --------------------------------------------------
+// Write the performance counts as JSON
+// --------------------------------------------------
+
+void tcpIpPg::writePerfJson (FILE* fp)
+{
+    tcpVpPerf_t perf                   = TcpVpGetPerf();
+    rxStats_t   stats                  = getStats();
+
+    // Simulated time at the nominal 10G clock, and wall clock time in seconds
+    double sim_secs                    = (double)perf.ticks / CLK10G_FREQ;
+    double wall_secs                   = (double)perf.wall_ns * 1e-9;
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"node\": %d,\n", node);
+    fprintf(fp, "  \"tx_frames\": %llu,\n",        (unsigned long long)perf.tx_frames);
+    fprintf(fp, "  \"tx_bytes\": %llu,\n",         (unsigned long long)perf.tx_bytes);
+    fprintf(fp, "  \"rx_frames\": %llu,\n",        (unsigned long long)perf.rx_frames);
+    fprintf(fp, "  \"rx_bytes\": %llu,\n",         (unsigned long long)perf.rx_bytes);
+    fprintf(fp, "  \"rx_payload_bytes\": %llu,\n", (unsigned long long)stats.payload_bytes);
+    fprintf(fp, "  \"rx_drops\": {\"bad_crc\": %llu, \"wrong_mac_addr\": %llu, \"bad_ipv4_chksum\": %llu, "
+                "\"wrong_ipv4_addr\": %llu, \"bad_tcp_chksum\": %llu, \"wrong_tcp_port\": %llu},\n",
+                (unsigned long long)stats.bad_crc,         (unsigned long long)stats.wrong_mac_addr,
+                (unsigned long long)stats.bad_ipv4_chksum, (unsigned long long)stats.wrong_ipv4_addr,
+                (unsigned long long)stats.bad_tcp_chksum,  (unsigned long long)stats.wrong_tcp_port);
+    fprintf(fp, "  \"ticks\": %llu,\n",            (unsigned long long)perf.ticks);
+    fprintf(fp, "  \"tx_busy_ticks\": %llu,\n",    (unsigned long long)perf.tx_busy_ticks);
+    fprintf(fp, "  \"tx_idle_ticks\": %llu,\n",    (unsigned long long)(perf.ticks > perf.tx_busy_ticks ? perf.ticks - perf.tx_busy_ticks : 0));
+    fprintf(fp, "  \"rx_busy_ticks\": %llu,\n",    (unsigned long long)perf.rx_busy_ticks);
+    fprintf(fp, "  \"rx_idle_ticks\": %llu,\n",    (unsigned long long)(perf.ticks > perf.rx_busy_ticks ? perf.ticks - perf.rx_busy_ticks : 0));
+    fprintf(fp, "  \"vp_writes\": %llu,\n",        (unsigned long long)perf.vp_writes);
+    fprintf(fp, "  \"vp_reads\": %llu,\n",         (unsigned long long)perf.vp_reads);
+    fprintf(fp, "  \"vp_burst_writes\": %llu,\n",  (unsigned long long)perf.vp_burst_writes);
+    fprintf(fp, "  \"vp_burst_reads\": %llu,\n",   (unsigned long long)perf.vp_burst_reads);
+    fprintf(fp, "  \"vp_ticks\": %llu,\n",         (unsigned long long)perf.vp_ticks);
+    fprintf(fp, "  \"wall_secs\": %.6f,\n",        wall_secs);
+    fprintf(fp, "  \"cpp_secs\": %.6f,\n",         (double)(perf.wall_ns - perf.vp_ns) * 1e-9);
+    fprintf(fp, "  \"vproc_secs\": %.6f,\n",       (double)perf.vp_ns * 1e-9);
+    fprintf(fp, "  \"sim_secs\": %.9f,\n",         sim_secs);
+    fprintf(fp, "  \"tx_gbps\": %.4f,\n",          sim_secs > 0 ? (double)perf.tx_bytes * 8 / sim_secs * 1e-9 : 0.0);
+    fprintf(fp, "  \"rx_gbps\": %.4f,\n",          sim_secs > 0 ? (double)perf.rx_bytes * 8 / sim_secs * 1e-9 : 0.0);
+    fprintf(fp, "  \"tx_utilisation\": %.4f,\n",   perf.ticks ? (double)perf.tx_busy_ticks / perf.ticks : 0.0);
+    fprintf(fp, "  \"rx_utilisation\": %.4f,\n",   perf.ticks ? (double)perf.rx_busy_ticks / perf.ticks : 0.0);
+    fprintf(fp, "  \"sim_ticks_per_wall_sec\": %.1f\n", wall_secs > 0 ? (double)perf.ticks / wall_secs : 0.0);
+    fprintf(fp, "}\n");
+}
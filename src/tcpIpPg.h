@@ -26,8 +26,29 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <atomic>
 
 #include "tcpVProc.h"
+#include "tcpCrc32.h"
+#include "tcpChksum.h"
+#include "tcpFrameRing.h"
+#include "tcpSlabPool.h"
+#include "tcpRxQueue.h"
+#include "tcpFlowTable.h"
+
+// Header fields are big endian, so fields loaded as words need swapping on little
+// endian hosts
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define TCP_IP_PG_NET16(_x) (_x)
+#define TCP_IP_PG_NET32(_x) (_x)
+#define TCP_IP_PG_NET64(_x) (_x)
+#define TCP_IP_PG_LE32(_x)  __builtin_bswap32(_x)
+#else
+#define TCP_IP_PG_NET16(_x) __builtin_bswap16(_x)
+#define TCP_IP_PG_NET32(_x) __builtin_bswap32(_x)
+#define TCP_IP_PG_NET64(_x) __builtin_bswap64(_x)
+#define TCP_IP_PG_LE32(_x)  (_x)
+#endif
 
 class tcpIpPg  : public tcpVProc
 {
@@ -43,17 +64,15 @@ public:
     static const uint32_t patch_version        = 4;
     
     // CRC32 parameters
-    static const uint32_t POLY                 = 0xEDB88320;  /* 0x04C11DB7 bit reversed */
-    static const uint32_t INIT                 = 0xFFFFFFFF;
-
-    // Nominal 10G clock frequency (Hz)
-    static const uint32_t CLK10G_FREQ          = 156250000;
+    static const uint32_t POLY                 = tcpCrc32::POLY;
+    static const uint32_t INIT                 = tcpCrc32::INIT;
 
     // IPv4 parameters
     static const uint32_t IPV4_MULTICAST_ADDR  = 0x00000000;
     static const uint32_t IPV4_SUBNET_MASK     = 0xffffffff;
     static const uint32_t IPV4_MIN_HDR_LEN     = 5;  // DWORDS
     static const uint32_t IPV4_SRC_ADDR_OFFSET = 3;  // DWORDS
+    static const uint32_t IPV4_CHKSUM_OFFSET   = 10; // BYTES
     
     // TCP parameters
     static const uint32_t IPV4_DST_ADDR_OFFSET = 4;  // DWORDS
@@ -61,6 +80,13 @@ public:
     static const uint32_t TCP_CHKSUM_OFFSET    = 16; // BYTES
     static const uint32_t TCP_PROTOCOL_NUM     = 6;
 
+    // Offset of the TCP payload in a generated frame buffer, after the preamble and the
+    // ethernet, IPv4 and TCP headers
+    static const uint32_t FRAME_PAYLOAD_OFFSET = ETH_PREAMBLE + ETH_HDR_LEN + (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4; // BYTES
+
+    // Largest TCP payload that fits in a frame of the MTU, with minimum size headers
+    static const uint32_t MAX_TCP_PAYLOAD      = ETH_MTU - (IPV4_MIN_HDR_LEN + TCP_MIN_HDR_LEN)*4; // BYTES
+
     // TCP header flag masks
     static const uint32_t TCP_FLAG_NS          = 0x100;
     static const uint32_t TCP_FLAG_CWR         = 0x080;
@@ -80,6 +106,32 @@ public:
     static const uint32_t RX_BAD_TCP_CHECKSUM  = 0x0010;
     static const uint32_t RX_WRONG_TCP_PORT    = 0x0020;
 
+    // Receive counter indexes. The error counts are in the order of the error mask bits.
+    static const uint32_t RX_CNT_CRC           = 0;
+    static const uint32_t RX_CNT_MAC_ADDR      = 1;
+    static const uint32_t RX_CNT_IPV4_CHKSUM   = 2;
+    static const uint32_t RX_CNT_IPV4_ADDR     = 3;
+    static const uint32_t RX_CNT_TCP_CHKSUM    = 4;
+    static const uint32_t RX_CNT_TCP_PORT      = 5;
+    static const uint32_t RX_CNT_FRAMES        = 6;
+    static const uint32_t RX_CNT_BYTES         = 7;
+    static const uint32_t RX_CNT_PAYLOAD       = 8;
+    static const uint32_t RX_NUM_ERR_TYPES     = 6;
+    static const uint32_t RX_NUM_COUNTS        = 9;
+
+    // Number of pooled buffers, in each size class, for received frames kept beyond
+    // their callback
+    static const uint32_t RX_POOL_BUFS_64      = 64;
+    static const uint32_t RX_POOL_BUFS_256     = 32;
+    static const uint32_t RX_POOL_BUFS_1522    = 32;
+
+    // Number of entries in a receive queue
+    static const uint32_t RX_QUEUE_SIZE        = 64;
+
+    // Length of the blocks in which the CRC and TCP checksum of a received segment are
+    // calculated together, so that each block is still in the cache for the second
+    static const uint32_t RX_CHECK_BLOCK_LEN   = 512; // BYTES (must be even)
+
     // --------------------------------------------
     // Type definitions
     // --------------------------------------------
@@ -117,9 +169,122 @@ public:
         uint64_t mac_dst_addr;
     } tcpConfig_t;
 
+    // Per-flow frame header template, with the fixed header fields for a connection already
+    // formed, and the partial checksums of those fields
+    typedef struct {
+        // Preamble and ethernet, IPv4 and TCP headers, with zero length, seq, ack, flags and window
+        uint8_t  hdr[FRAME_PAYLOAD_OFFSET];
+
+        // IPv4 header checksum for the template's total length
+        uint32_t ipv4_chksum;
+
+        // Unfolded sum of the fixed TCP header and pseudo-header fields
+        uint32_t tcp_partial;
+
+        // Unfolded sum of the pseudo-header addresses and protocol only
+        uint32_t tcp_pseudo;
+    } tcpFlowTemplate_t;
+
+    // TCP checksum generation on transmit: full checksum, only the pseudo-header sum (as
+    // handed to a NIC offloading the checksum), or left zero
+    typedef enum {
+        TX_TCP_CHKSUM_FULL = 0,
+        TX_TCP_CHKSUM_PARTIAL,
+        TX_TCP_CHKSUM_NONE
+    } txTcpChksum_t;
+
+    // Structure for checksum offload settings, emulating a NIC doing checksum insertion
+    // on transmit and checking on receive
+    typedef struct {
+        // Generate the IPv4 header checksum on transmit (else left zero)
+        bool          tx_ipv4_chksum;
+
+        // TCP checksum generation on transmit
+        txTcpChksum_t tx_tcp_chksum;
+
+        // Receive checks to skip, as a mask of RX_BAD_CRC, RX_BAD_IPV4_CHECKSUM and RX_BAD_TCP_CHECKSUM.
+        // The length checks are never skipped: a bad IPv4 total length is counted as a bad IPv4
+        // checksum, and a TCP data offset beyond the segment as a bad TCP checksum.
+        uint32_t      rx_skip_checks;
+    } chksumOffload_t;
+
+    // Logging of dropped received frames: every frame, only the 1st, 2nd, 4th, 8th etc.
+    // of each error type, or none (with the totals available from getStats/printStats)
+    typedef enum {
+        RX_LOG_ALL = 0,
+        RX_LOG_RATE_LIMITED,
+        RX_LOG_SUMMARY
+    } rxLogMode_t;
+
+    // Structure for a snapshot of the receive counts: frames dropped for each error type,
+    // and frames accepted, with their frame and TCP payload bytes
+    typedef struct {
+        uint64_t bad_crc;
+        uint64_t wrong_mac_addr;
+        uint64_t bad_ipv4_chksum;
+        uint64_t wrong_ipv4_addr;
+        uint64_t bad_tcp_chksum;
+        uint64_t wrong_tcp_port;
+        uint64_t frames;
+        uint64_t bytes;
+        uint64_t payload_bytes;
+    } rxStats_t;
+
+    // Structure for the parsed headers of a received packet
+    typedef struct {
+        uint64_t mac_src_addr;
+        uint32_t ipv4_src_addr;
+        uint32_t tcp_src_port;
+        uint32_t tcp_dst_port;
+        uint32_t tcp_seq_num;
+        uint32_t tcp_ack_num;
+        uint32_t tcp_flags;
+        uint32_t tcp_win_size;
+    } rxHdr_t;
+
+    // Structure for a view of a received frame (without preamble, but with CRC) and
+    // of its TCP payload within it
+    typedef struct {
+        const uint8_t* frame;
+        uint32_t       frame_len;
+        const uint8_t* payload;
+        uint32_t       payload_len;
+    } rxView_t;
+
+    // Structure for a received frame kept in a pooled buffer, with the view into the buffer
+    typedef struct {
+        rxHdr_t                hdr;
+        rxView_t               view;
+        tcpSlabPool::pktBuf_t  pkt;
+    } rxFrame_t;
+
     // Type definition for user callback function to receive packets
     typedef void (*pUsrRxCbFunc_t) (rxInfo_t rx_info, void* hdl);
 
+    // Type definition for user callback function to receive packet views. The view is
+    // only valid for the duration of the callback (see keepFrame).
+    typedef void (*pUsrRxViewCbFunc_t) (const rxHdr_t* rx_hdr, const rxView_t* rx_view, void* hdl);
+
+    // Type definition for a bounded queue of received packets, filled from a receive
+    // callback and emptied by the test code
+    typedef tcpRxQueue<rxInfo_t> rxQueue_t;
+
+    // Type definition for a bounded queue of kept frames
+    typedef tcpRxQueue<rxFrame_t> rxFrameQueue_t;
+
+    // Structure for the receive state of a flow: its callbacks and handle (as for the node's
+    // callbacks), and the frames and TCP payload bytes received for it
+    typedef struct {
+        pUsrRxCbFunc_t     rx_func;
+        pUsrRxViewCbFunc_t rx_view_func;
+        void*              hdl;
+        uint64_t           frames;
+        uint64_t           payload_bytes;
+    } flow_t;
+
+    // Type definition for a table of flows, keyed on the 4-tuple
+    typedef tcpFlowTable<flow_t> flowTable_t;
+
     // --------------------------------------------
     // Constructor
     // --------------------------------------------
@@ -128,9 +293,20 @@ public:
                                         tcpVProc(nodeIn),
                                         ipv4_addr(ipv4AddrIn),
                                         mac_addr(macAddrIn),
-                                        tcp_port(tcpPortIn)
+                                        tcp_port(tcpPortIn),
+                                        rx_pool(rxPoolBufs())
     {
         usrRxCbFunc                    = NULL;
+        usrRxViewCbFunc                = NULL;
+
+        offload.tx_ipv4_chksum         = true;
+        offload.tx_tcp_chksum          = TX_TCP_CHKSUM_FULL;
+        offload.rx_skip_checks         = 0;
+
+        rx_log_mode                    = RX_LOG_ALL;
+        resetStats();
+        hdl                            = NULL;
+        view_hdl                       = NULL;
     };
 
     // --------------------------------------------
@@ -140,32 +316,146 @@ public:
     // Function to register user callback function to receive packets
     void           registerUsrRxCbFunc (pUsrRxCbFunc_t pFunc, void* hdlIn) { usrRxCbFunc = pFunc; hdl = hdlIn;};
 
-    // Method to generate a TCP/IPv4 packet
+    // Function to register user callback function to receive packet views, without copying.
+    // If both callbacks are registered, this one is called first.
+    void           registerUsrRxViewCbFunc (pUsrRxViewCbFunc_t pFunc, void* hdlIn) { usrRxViewCbFunc = pFunc; view_hdl = hdlIn;};
+
+    // Method to keep a received frame beyond its view callback, by copying it into a pooled
+    // buffer sized to the frame. Returns false if no buffers are free. The frame must be
+    // released with releaseFrame when finished with.
+    bool           keepFrame           (const rxHdr_t* rx_hdr, const rxView_t* rx_view, rxFrame_t &kept);
+
+    // Method to add a reference to a kept frame, for each extra copy of it held (such as
+    // on a second queue). Each copy is released separately.
+    void           retainFrame         (const rxFrame_t &kept) {rx_pool.retain(kept.pkt);};
+
+    // Method to drop a reference to a kept frame, returning its buffer to the pool when
+    // there are none left
+    void           releaseFrame        (rxFrame_t &kept) {rx_pool.release(kept.pkt);};
+
+    // Pool of buffers for kept frames, for its status and high-water marks
+    tcpSlabPool&   rxPool              (void) {return rx_pool;};
+
+    // Method to add a flow, for the connection between local_port on this node and
+    // remote_port at remote_addr, with its own receive callbacks and handle (either callback
+    // may be NULL). Frames for the flow are passed to these instead of the node's callbacks,
+    // and are accepted even if local_port isn't the node's port. Returns false if the flow
+    // table is full or the flow already added.
+    bool           addFlow             (uint32_t           remote_addr,
+                                        uint32_t           remote_port,
+                                        uint32_t           local_port,
+                                        pUsrRxCbFunc_t     pFunc,
+                                        void*              hdlIn,
+                                        pUsrRxViewCbFunc_t pViewFunc = NULL);
+
+    // Method to set the most flows that can be added (tcpFlowTable::DEFAULT_MAX_FLOWS
+    // unless set), with no flows added. The flow table is allocated for them when the
+    // first flow is added, so nodes without flows don't hold one. Returns false if
+    // flows have been added.
+    bool           setMaxFlows         (uint32_t max_flows);
+
+    // Method to remove a flow. Returns false if not found.
+    bool           removeFlow          (uint32_t remote_addr, uint32_t remote_port, uint32_t local_port);
+
+    // Method returning a flow's receive state (valid until a flow is next removed), or
+    // NULL if not found
+    const flow_t*  getFlow             (uint32_t remote_addr, uint32_t remote_port, uint32_t local_port);
+
+    // Number of flows added
+    uint32_t       numFlows            (void) {return flows.size();};
+
+    // Method to wait until a received packet has been passed to the user callback, or
+    // until timeout_ticks have elapsed. Returns true if a packet was received.
+    bool           waitForRx           (uint32_t timeout_ticks = WAIT_FOREVER) {return TcpVpWaitForRx(timeout_ticks);};
+
+    // Method to generate a TCP/IPv4 packet as packed bytes. The first and last bytes of
+    // the frame are the start and end of frame delimiters. The frame buffer must be at least
+    // ETH_MAX_FRAME_LEN bytes.
+    uint32_t       genTcpIpPkt         (tcpConfig_t &cfg, uint8_t* frm_buf, const uint8_t* payload, uint32_t payload_len);
+
+    // Method to generate a TCP/IPv4 packet in place, around a payload already placed in
+    // frm_buf at FRAME_PAYLOAD_OFFSET (see getPayloadPtr)
+    uint32_t       genTcpIpPktInPlace  (tcpConfig_t &cfg, uint8_t* frm_buf, uint32_t payload_len);
+
+    // Method to initialise a flow template from the connection fields of cfg (dst_port,
+    // ip_dst_addr and mac_dst_addr), with a source port of the node's port, or of src_port
+    // for a flow on another local port (see addFlow)
+    void           initFlowTemplate    (tcpFlowTemplate_t &tmpl, tcpConfig_t &cfg) {initFlowTemplate(tmpl, cfg, tcp_port);};
+    void           initFlowTemplate    (tcpFlowTemplate_t &tmpl, tcpConfig_t &cfg, uint32_t src_port);
+
+    // Method to generate a TCP/IPv4 packet in place from a flow template, around a payload
+    // already placed in frm_buf at FRAME_PAYLOAD_OFFSET. Only the seq_num, ack_num, flag and
+    // win_size fields of cfg are used.
+    uint32_t       genTcpIpPkt         (tcpFlowTemplate_t &tmpl, tcpConfig_t &cfg, uint8_t* frm_buf, uint32_t payload_len);
+
+    // Method to generate a batch of TCP/IPv4 packets, splitting total_len bytes of payload into
+    // segments of up to mss bytes, with consecutive sequence numbers, into the free slots of
+    // out_ring. cfg.seq_num is advanced past the data generated. Returns the number of payload
+    // bytes generated, which is less than total_len if the ring fills.
+    uint32_t       genTcpIpPktBatch    (tcpConfig_t &cfg, const uint8_t* payload, uint32_t total_len, uint32_t mss, tcpFrameRing &out_ring);
+
+    // Method to send the frames queued in ring, oldest first, each released when the node's
+    // shaper (see TcpVpSetTxRate) and any flow_shaper allow. If wait is false, returns at the
+    // first frame the flow shaper doesn't yet allow, so several flows' rings can be serviced
+    // in turn. Returns the number of frames sent.
+    uint32_t       sendFrames          (tcpFrameRing &ring, tcpShaper* flow_shaper = NULL, bool wait = true);
+
+    // Method returning where in a frame buffer the payload should be placed for genTcpIpPktInPlace
+    uint8_t*       getPayloadPtr       (uint8_t* frm_buf) {return &frm_buf[FRAME_PAYLOAD_OFFSET];};
+
+    // Method to generate a TCP/IPv4 packet with one byte per word, with bit 8 set on
+    // control characters
     uint32_t       genTcpIpPkt         (tcpConfig_t &cfg, uint32_t* frm_buf, uint32_t* payload, uint32_t payload_len);
     
     void           getVersionString    (char* version_str, uint32_t maxlen = 12) {
                                             snprintf(version_str, maxlen, "%d.%d.%d", major_version, minor_version, patch_version);} 
 
+    // Set and get the checksum offload emulation for this node. By default all checksums are
+    // generated and all checks made.
+    void           setChksumOffload    (const chksumOffload_t &offloadIn) {offload = offloadIn;};
+    chksumOffload_t getChksumOffload   (void) {return offload;};
+
+    // Set the logging of dropped received frames
+    void           setRxLogMode        (rxLogMode_t mode) {rx_log_mode = mode;};
+
+    // Methods to get a snapshot of, clear, and display the receive counts
+    rxStats_t      getStats            (void);
+    void           resetStats          (void);
+    void           printStats          (void);
+
+    // Method to write the performance counts (see TcpVpGetPerf), the receive counts and
+    // the derived simulated link rates and utilisation, as a JSON object
+    void           writePerfJson       (FILE* fp);
+
+    // Select the CRC engine (returns engine actually selected) and run its self-test against
+    // the bitwise reference (returns number of mismatches)
+    tcpCrc32::crcEngine_t setCrcEngine (tcpCrc32::crcEngine_t engine) {return crc_engine.setEngine(engine);};
+    uint32_t       crcSelfTest         (bool verbose = false) {return crc_engine.selfTest(verbose);};
+
 private:
 
     // --------------------------------------------
     // Private methods
     // --------------------------------------------
     
-    // Method to construct an ethernet frame with (optional) payload
-    uint32_t       ethFrame            (uint32_t* eth_frame,  uint32_t* payload, uint32_t payload_len, uint64_t dst_addr);
+    // Method to check that a payload fits in a TCP/IPv4 frame, reporting an error if not
+    bool           payloadLenOk        (uint32_t payload_len);
+
+    // Method to construct an ethernet frame around an (optional) payload already in place
+    uint32_t       ethFrame            (uint8_t* eth_frame, uint32_t payload_len, uint64_t dst_addr);
+
+    // Method to add padding, CRC and end of frame delimiter to an ethernet frame with headers
+    uint32_t       ethFrameTail        (uint8_t* eth_frame, uint32_t payload_len);
     
     
-    // Method to construct an IPV4 frame with (optional) payload
-    uint32_t       ipv4Frame           (uint32_t* ipv4_frame,
-                                        uint32_t* payload,
+    // Method to construct an IPV4 frame around an (optional) payload already in place
+    uint32_t       ipv4Frame           (uint8_t*  ipv4_frame,
                                         uint32_t  payload_len,
                                         uint32_t  ipv4_dst_addr,
                                         bool      add_tcp_chksum = true);
 
-    // Method to construct a TCP segment with (optional) payload
-    uint32_t       tcpSegment          (uint32_t* tcp_seg,
-                                        uint32_t* payload,
+    // Method to construct a TCP segment around an (optional) payload already in place
+    uint32_t       tcpSegment          (uint8_t*  tcp_seg,
                                         uint32_t  payload_len,
                                         uint32_t  dst_port,
                                         uint32_t  seq_num,
@@ -177,17 +467,37 @@ private:
                                         uint32_t  window_size = 32768);
 
     // Method for processing raw receive data
-    uint32_t       processFrame        (uint32_t* rx_buff, uint32_t rx_len);
+    uint32_t       processFrame        (const uint8_t* rx_buff, uint32_t rx_len);
+
+    // Method for counting a received runt frame, which can't have a good CRC
+    void           dropRuntFrame       (void) {rxDrop(RX_BAD_CRC);};
 
     // Ethernet CR32 calculation method
-    uint32_t       crc32               (uint32_t* buf, uint32_t len, uint32_t poly = POLY, uint32_t init = INIT, bool debug = false);
+    uint32_t       crc32               (const uint8_t* buf, uint32_t len, uint32_t poly = POLY, uint32_t init = INIT, bool debug = false);
     
-    // Method to calculate IP4v checksum. Also used (in ipv4frame) to calculate TCP checksum
-    uint32_t       ipv4_chksum         (uint32_t* buf, uint32_t len, bool debug = false);
+    // Method to calculate IP4v checksum. Also used (in ipv4frame) to calculate TCP checksum.
+    // Returns the one's complement sum folded to 16 bits (not inverted).
+    uint32_t       ipv4_chksum         (const uint8_t* buf, uint32_t len, bool debug = false);
     
     // Method to extract receive data
     void           extractRx           (void);
 
+    // Method returning the flow table key for a connection with this node's address
+    flowTable_t::flowKey_t flowKey     (uint32_t remote_addr, uint32_t remote_port, uint32_t local_port)
+    {
+        flowTable_t::flowKey_t key     = {ipv4_addr, remote_addr, local_port, remote_port};
+        return key;
+    };
+
+    // Method to count and log a dropped received frame. Returns the error mask.
+    uint32_t       rxDrop              (uint32_t error);
+
+    // Unaligned loads of big endian (network order) fields, and of the little endian CRC
+    static uint32_t loadBe16           (const uint8_t* buf) {uint16_t val; memcpy(&val, buf, 2); return TCP_IP_PG_NET16(val);};
+    static uint32_t loadBe32           (const uint8_t* buf) {uint32_t val; memcpy(&val, buf, 4); return TCP_IP_PG_NET32(val);};
+    static uint64_t loadBe64           (const uint8_t* buf) {uint64_t val; memcpy(&val, buf, 8); return TCP_IP_PG_NET64(val);};
+    static uint32_t loadLe32           (const uint8_t* buf) {uint32_t val; memcpy(&val, buf, 4); return TCP_IP_PG_LE32(val);};
+
     // --------------------------------------------
     // Private member variables
     // --------------------------------------------
@@ -201,12 +511,40 @@ private:
     // This node's MAC address
     uint64_t       mac_addr;
 
+    // CRC calculation engine for the Ethernet polynomial
+    tcpCrc32       crc_engine;
+
+    // Checksum offload emulation settings
+    chksumOffload_t offload;
+
+    // Receive counts (updated by the receive path, read by any thread), and logging mode
+    std::atomic<uint64_t> rx_counts[RX_NUM_COUNTS];
+    rxLogMode_t    rx_log_mode;
+
     // Pointer to the user's receive callback function
     pUsrRxCbFunc_t usrRxCbFunc;
     
     // Handle passed in with callback registration as pointer to calling class instance ('this' pointer).
     // Used to reference specific instances' methods and member variables.
     void*          hdl;
+
+    // Pointer to the user's receive view callback function, and its handle
+    pUsrRxViewCbFunc_t usrRxViewCbFunc;
+    void*          view_hdl;
+
+    // Number of buffers in each size class of the kept frame pool
+    static const uint32_t* rxPoolBufs  (void)
+    {
+        static const uint32_t bufs[tcpSlabPool::NUM_SIZE_CLASSES] = {RX_POOL_BUFS_64, RX_POOL_BUFS_256,
+                                                                      RX_POOL_BUFS_1522};
+        return bufs;
+    };
+
+    // Pool of buffers for kept received frames
+    tcpSlabPool    rx_pool;
+
+    // Flows demultiplexed by the receive path, with their receive state
+    flowTable_t    flows;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class template for a bounded ring queue of received packets,
+// with pre-allocated slots, safe for a single producer and a
+// single consumer
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_RX_QUEUE_H_
+#define _TCP_RX_QUEUE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+
+template <class T> class tcpRxQueue
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    static const uint32_t DEFAULT_CAPACITY     = 64;
+
+    // --------------------------------------------
+    // Constructor and destructor
+    // --------------------------------------------
+
+    // Allocate slots for at least capacityIn entries, rounded up to a power of two
+    tcpRxQueue (uint32_t capacityIn = DEFAULT_CAPACITY)
+    {
+        num_slots                      = 1;
+        while (num_slots < capacityIn)
+        {
+            num_slots                  <<= 1;
+        }
+
+        mask                           = num_slots - 1;
+        slots                          = new T[num_slots];
+        head                           = 0;
+        tail                           = 0;
+        ovfl_count                     = 0;
+    };
+
+    ~tcpRxQueue ()
+    {
+        delete [] slots;
+    };
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Status of the queue. Head and tail are free running, so the difference is the
+    // number of entries even when they wrap.
+    bool           empty               (void) {return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);};
+    bool           full                (void) {return size() == num_slots;};
+    uint32_t       size                (void) {return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);};
+    uint32_t       capacity            (void) {return num_slots;};
+
+    // Number of entries lost because the queue was full
+    uint32_t       overflowCount       (void) {return ovfl_count;};
+
+    // Producer: copy an entry onto the queue. Returns false, and counts the overflow,
+    // if full.
+    bool           push                (const T &entry)
+    {
+        T* slot                        = nextFree();
+
+        if (slot == NULL)
+        {
+            return false;
+        }
+
+        *slot                          = entry;
+        commit();
+
+        return true;
+    };
+
+    // Producer: slot to fill in place with the next entry (or NULL, counting the
+    // overflow, if full), then add it to the queue with commit
+    T*             nextFree            (void)
+    {
+        uint32_t h                     = head.load(std::memory_order_relaxed);
+
+        if (h - tail.load(std::memory_order_acquire) == num_slots)
+        {
+            ovfl_count++;
+            return NULL;
+        }
+
+        return &slots[h & mask];
+    };
+
+    void           commit              (void) {head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);};
+
+    // Consumer: the oldest entry, or the idx'th from the oldest. The queue must have
+    // more than idx entries.
+    T&             front               (void) {return slots[tail.load(std::memory_order_relaxed) & mask];};
+    T&             peek                (uint32_t idx) {return slots[(tail.load(std::memory_order_relaxed) + idx) & mask];};
+
+    // Consumer: remove the oldest entry. Returns false if the queue was empty.
+    bool           pop                 (void)
+    {
+        if (empty())
+        {
+            return false;
+        }
+
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        return true;
+    };
+
+    // Consumer: remove entries from the front until one matches the predicate (called with
+    // each entry as the argument), which is left at the front, or the queue is empty.
+    // Returns the number of entries removed.
+    template <class P> uint32_t dropUntil (P match)
+    {
+        uint32_t count                 = 0;
+
+        while (!empty() && !match(front()))
+        {
+            pop();
+            count++;
+        }
+
+        return count;
+    };
+
+    // Consumer: discard all entries
+    void           clear               (void) {tail.store(head.load(std::memory_order_acquire), std::memory_order_release);};
+
+private:
+
+    // Not copyable, as the queue owns its slot storage
+    tcpRxQueue (const tcpRxQueue&);
+    tcpRxQueue& operator= (const tcpRxQueue&);
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Slot storage, number of slots (a power of two) and index mask
+    T*             slots;
+    uint32_t       num_slots;
+    uint32_t       mask;
+
+    // Free running producer and consumer counts, indexing slots modulo num_slots
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    // Number of entries lost when full (updated by the producer only)
+    uint32_t       ovfl_count;
+};
+
+#endif
@@ -0,0 +1,156 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class for a token bucket rate shaper, timed in clock ticks,
+// deciding when frames may be sent to hold a configured bit
+// rate and burst size
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_SHAPER_H_
+#define _TCP_SHAPER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+class tcpShaper
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    // Longest delay returned, so it fits a tick count (callers check again after waiting)
+    static const uint32_t MAX_DELAY            = 0x40000000; // TICKS
+
+    // --------------------------------------------
+    // Constructor
+    // --------------------------------------------
+
+    // Shaper timed by a clock of clkFreqIn Hz, initially disabled
+    tcpShaper (uint32_t clkFreqIn) : clk_freq(clkFreqIn)
+    {
+        setRate(0, 0);
+    };
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Set the rate in bits per second (0 to disable shaping), and the burst size in bytes,
+    // being the most that may be sent at once after the rate has been unused. A frame larger
+    // than the burst size is sent when the bucket is full, and paid for afterwards. The
+    // bucket starts full on the first frame.
+    void           setRate             (uint64_t rate_bps, uint32_t burst_bytes)
+    {
+        rate                           = rate_bps;
+        burst                          = burst_bytes;
+        capacity                       = (int64_t)(burst_bytes ? burst_bytes : 1) * 8 * clk_freq;
+        tokens                         = capacity;
+        started                        = false;
+    };
+
+    // Configured rate and burst size, and whether shaping
+    uint64_t       getRate             (void) {return rate;};
+    uint32_t       getBurst            (void) {return burst;};
+    bool           enabled             (void) {return rate != 0;};
+
+    // Ticks from now until a frame of len bytes may be sent, or 0 if it may be sent now
+    uint32_t       delay               (uint32_t now, uint32_t len)
+    {
+        if (!enabled())
+        {
+            return 0;
+        }
+
+        refill(now);
+
+        int64_t  cost                  = (int64_t)len * 8 * clk_freq;
+        int64_t  needed                = ((cost < capacity) ? cost : capacity) - tokens;
+
+        if (needed <= 0)
+        {
+            return 0;
+        }
+
+        uint64_t ticks                 = ((uint64_t)needed + rate - 1) / rate;
+
+        return (ticks > MAX_DELAY) ? MAX_DELAY : (uint32_t)ticks;
+    };
+
+    // Take the tokens for a frame of len bytes sent at now
+    void           send                (uint32_t now, uint32_t len)
+    {
+        if (enabled())
+        {
+            refill(now);
+            tokens                     -= (int64_t)len * 8 * clk_freq;
+        }
+    };
+
+private:
+
+    // --------------------------------------------
+    // Private methods
+    // --------------------------------------------
+
+    // Add the tokens for the ticks since the last refill, up to the bucket's capacity. The
+    // ticks are limited to those filling the bucket before multiplying, so the product
+    // can't overflow.
+    void           refill              (uint32_t now)
+    {
+        if (!started)
+        {
+            last_tick                  = now;
+            started                    = true;
+        }
+
+        uint64_t elapsed               = (uint32_t)(now - last_tick);
+        uint64_t to_fill               = (uint64_t)(capacity - tokens) / rate + 1;
+
+        elapsed                        = (elapsed > to_fill) ? to_fill : elapsed;
+        tokens                         += (int64_t)(elapsed * rate);
+        tokens                         = (tokens > capacity) ? capacity : tokens;
+        last_tick                      = now;
+    };
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // Clock frequency of the tick count (Hz)
+    uint64_t       clk_freq;
+
+    // Rate (bits per second) and burst size (bytes) configured
+    uint64_t       rate;
+    uint32_t       burst;
+
+    // Tokens, and the bucket's capacity, in units of 1/clk_freq bits, so that each tick adds
+    // the rate in bits per second exactly. The tokens go negative after a frame larger
+    // than the tokens held when sent.
+    int64_t        tokens;
+    int64_t        capacity;
+
+    // Tick count when last refilled, and whether refilled since the rate was set
+    uint32_t       last_tick;
+    bool           started;
+};
+
+#endif
@@ -0,0 +1,198 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class for a pool of pre-allocated packet buffers in a set of
+// size classes, with reference counted handles, so packets can
+// be kept, shared and released without heap allocation
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_SLAB_POOL_H_
+#define _TCP_SLAB_POOL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tcpFramePool.h"
+
+class tcpSlabPool
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    // Buffer size classes: minimum frame, small segment, and the largest frame received
+    // (standard, with an 802.1Q tag, as tcpVProc::ETH_MAX_RX_LEN less the preamble). There
+    // is no jumbo class, as the receive path doesn't support jumbo frames.
+    static const uint32_t NUM_SIZE_CLASSES     = 3;
+    static const uint32_t SIZE_CLASS_0         = 64;
+    static const uint32_t SIZE_CLASS_1         = 256;
+    static const uint32_t SIZE_CLASS_2         = 1522;
+
+    // --------------------------------------------
+    // Type definitions
+    // --------------------------------------------
+
+    // Handle for a buffer taken from the pool. Handles may be copied freely, with
+    // retain/release keeping count of the copies in use.
+    typedef struct {
+        uint8_t* buf;
+        uint32_t len;
+        uint32_t cls;
+        uint32_t idx;
+    } pktBuf_t;
+
+    // --------------------------------------------
+    // Constructor and destructor
+    // --------------------------------------------
+
+    // Allocate numBufs[n] buffers for each size class n
+    tcpSlabPool (const uint32_t numBufs[NUM_SIZE_CLASSES])
+    {
+        for (uint32_t cls = 0; cls < NUM_SIZE_CLASSES; cls++)
+        {
+            pools[cls]                 = new tcpFramePool(numBufs[cls], classSize(cls));
+            ref_counts[cls]            = new uint32_t[numBufs[cls]];
+            alloc_fails[cls]           = 0;
+        }
+    };
+
+    ~tcpSlabPool ()
+    {
+        for (uint32_t cls = 0; cls < NUM_SIZE_CLASSES; cls++)
+        {
+            delete pools[cls];
+            delete [] ref_counts[cls];
+        }
+    };
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Buffer size of a size class
+    static uint32_t classSize          (uint32_t cls)
+    {
+        switch (cls)
+        {
+        case 0:  return SIZE_CLASS_0;
+        case 1:  return SIZE_CLASS_1;
+        default: return SIZE_CLASS_2;
+        }
+    };
+
+    // Take a buffer for len bytes, from the smallest size class that fits, or from a
+    // larger class if that has none free. The handle starts with a reference count of
+    // one. Returns false, with a NULL buf, if there is no free buffer large enough.
+    bool           alloc               (uint32_t len, pktBuf_t &pkt)
+    {
+        pkt.buf                        = NULL;
+        pkt.len                        = len;
+
+        uint32_t cls                   = 0;
+
+        while (cls < NUM_SIZE_CLASSES && len > classSize(cls))
+        {
+            cls++;
+        }
+
+        if (cls < NUM_SIZE_CLASSES)
+        {
+            // Only count a failure against the class that should have been used
+            uint32_t fit_cls           = cls;
+
+            for (; cls < NUM_SIZE_CLASSES; cls++)
+            {
+                if ((pkt.buf = pools[cls]->alloc()) != NULL)
+                {
+                    pkt.cls            = cls;
+                    pkt.idx            = pools[cls]->index(pkt.buf);
+                    ref_counts[cls][pkt.idx] = 1;
+
+                    return true;
+                }
+            }
+
+            alloc_fails[fit_cls]++;
+        }
+
+        return false;
+    };
+
+    // Add a reference to a buffer, for another copy of its handle
+    void           retain              (const pktBuf_t &pkt) {if (pkt.buf) ref_counts[pkt.cls][pkt.idx]++;};
+
+    // Drop a reference to a buffer, returning it to the pool when there are none left.
+    // The handle is cleared. Returns true if the buffer was returned to the pool.
+    bool           release             (pktBuf_t &pkt)
+    {
+        bool freed                     = false;
+
+        if (pkt.buf && --ref_counts[pkt.cls][pkt.idx] == 0)
+        {
+            pools[pkt.cls]->free(pkt.buf);
+            freed                      = true;
+        }
+
+        pkt.buf                        = NULL;
+
+        return freed;
+    };
+
+    // Number of references to a buffer
+    uint32_t       refCount            (const pktBuf_t &pkt) {return pkt.buf ? ref_counts[pkt.cls][pkt.idx] : 0;};
+
+    // Status of a size class, for sizing the pool to a traffic profile
+    uint32_t       capacity            (uint32_t cls) {return pools[cls]->capacity();};
+    uint32_t       inUse               (uint32_t cls) {return pools[cls]->inUse();};
+    uint32_t       highWater           (uint32_t cls) {return pools[cls]->highWater();};
+    uint32_t       allocFails          (uint32_t cls) {return alloc_fails[cls];};
+
+    // Display the status of all the size classes
+    void           printStats          (FILE* fp = stdout)
+    {
+        for (uint32_t cls = 0; cls < NUM_SIZE_CLASSES; cls++)
+        {
+            fprintf(fp, "  %4d byte buffers : %4d in use, %4d high water, %4d capacity, %4d failed allocations\n",
+                        classSize(cls), inUse(cls), highWater(cls), capacity(cls), allocFails(cls));
+        }
+    };
+
+private:
+
+    // Not copyable, as the pool owns its buffer storage
+    tcpSlabPool (const tcpSlabPool&);
+    tcpSlabPool& operator= (const tcpSlabPool&);
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    // A fixed size pool of buffers for each size class, with a reference count for
+    // each buffer
+    tcpFramePool*  pools[NUM_SIZE_CLASSES];
+    uint32_t*      ref_counts[NUM_SIZE_CLASSES];
+
+    // Number of allocations not met, by the size class that fitted the length
+    uint32_t       alloc_fails[NUM_SIZE_CLASSES];
+};
+
+#endif
@@ -27,18 +27,35 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <chrono>
 
 extern "C" {
 #include "VUser.h"
 }
 
+#include "tcpShaper.h"
+
+// Frame bytes loaded as a 64 bit word have the first byte in the least significant
+// lane on little endian hosts, and need swapping on big endian hosts
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define TCP_VP_LANE_ORDER64(_x) __builtin_bswap64(_x)
+#else
+#define TCP_VP_LANE_ORDER64(_x) (_x)
+#endif
+
 class tcpVProc
 {
 
 protected :
 
     // Virtual method, provided by derived class, where received data is sent
-    virtual uint32_t processFrame (uint32_t* rx_buf, uint32_t rx_len) = 0;
+    // as packed bytes (with the preamble removed)
+    virtual uint32_t processFrame (const uint8_t* rx_buf, uint32_t rx_len) = 0;
+
+    // Virtual method, provided by derived class, where a received frame too short to
+    // be valid (a runt) is counted, rather than being passed to processFrame
+    virtual void     dropRuntFrame (void) = 0;
 
     // The VProc node for the tcpClient HDL model
     int              node;
@@ -49,19 +66,55 @@ public:
     // Static constants
     // --------------------------------------------
 
+    // Nominal 10G clock frequency (Hz)
+    static const uint32_t CLK10G_FREQ          = 156250000;
+
     // tcpClient VProc address offsets
     static const uint32_t TXD_LO_ADDR          = 0;
     static const uint32_t TXD_HI_ADDR          = 1;
     static const uint32_t TXC_ADDR             = 2;
     static const uint32_t TICKS_ADDR           = 3;
     static const uint32_t HALT_ADDR            = 4;
+    static const uint32_t TXSEND_ADDR          = 5;
+    static const uint32_t RXCOUNT_ADDR         = 6;
+    static const uint32_t TXSPACE_ADDR         = 7;
+    static const uint32_t IRQEN_ADDR           = 8;
+    static const uint32_t IDLE_ADDR            = 9;
+    static const uint32_t TXBUF_ADDR           = 0x10000;
+    static const uint32_t RXBUF_ADDR           = 0x20000;
+
+    // HDL TX FIFO and RX buffer depths, and 32 bit words transferred per XGMII
+    // word (data low, data high and control)
+    static const uint32_t TXBUF_DEPTH          = 2048; // XGMII WORDS
+    static const uint32_t RXBUF_DEPTH          = 1024; // XGMII WORDS
+    static const uint32_t XGMII_BURST_WORDS    = 3;
+
+    // Maximum ticks between RX buffer drains in burst mode, and the maximum
+    // XGMII words read in a single burst
+    static const uint32_t RX_DRAIN_TICKS       = RXBUF_DEPTH/2;
+    static const uint32_t RX_BURST_LEN         = 256;  // XGMII WORDS
+
+    // RX buffer status fields
+    static const uint32_t RXCOUNT_MASK         = 0xffff;
+    static const uint32_t RXCOUNT_OVFL_SHIFT   = 16;
 
-    // Ethernet tags and frame delimeters
+    // Timeout value to wait for received data indefinitely, and the maximum ticks
+    // for a single HDL idle wait
+    static const uint32_t WAIT_FOREVER         = 0xffffffff;
+    static const uint32_t MAX_IDLE_WAIT        = 0x40000000;
+
+    // VProc interrupt level for completed RX frames, and maximum number of nodes
+    // (tcp_ip_pg has a 4 bit node number)
+    static const int      RX_IRQ_LEVEL         = 1;
+    static const int      MAX_NODES            = 16;
+
+    // Ethernet tags and frame delimeters (bit 8 set for XGMII control characters)
     static const uint32_t IDLE                 = 0x107;
     static const uint32_t SOF                  = 0x1fb;
     static const uint32_t EoF                  = 0x1fd;
     static const uint32_t PREAMBLE             = 0x055;
     static const uint32_t SFD                  = 0x0d5;
+    static const uint32_t CTRL_BIT             = 0x100;
 
     // Ethernet parameters and header dimensions
     static const uint32_t ETH_MTU              = 1500;
@@ -69,18 +122,280 @@ public:
     static const uint32_t ETH_802_1Q_LEN       = 4;  // BYTES
     static const uint32_t ETH_CRC_LEN          = 4;  // BYTES
     static const uint32_t ETH_HDR_LEN          = 14; // BYTES
+    static const uint32_t ETH_MIN_PAYLOAD      = 46; // BYTES
+
+    // Minimum frame length, from destination MAC to CRC, with the payload padded
+    static const uint32_t ETH_MIN_FRAME_LEN    = ETH_HDR_LEN + ETH_MIN_PAYLOAD + ETH_CRC_LEN;
+
+    // Nominal inter-packet gap (including the terminate character), and the most it may
+    // be short by to start a frame on lane 0 or lane 4, made up by later gaps
+    static const uint32_t ETH_IPG              = 12; // BYTES
+    static const uint32_t ETH_MAX_IDLE_DEFICIT = 3;  // BYTES
+
+    // Maximum received frame length, including preamble, and maximum transmitted
+    // frame length, which also has the end-of-frame delimiter
+    static const uint32_t ETH_MAX_RX_LEN       = ETH_MTU + ETH_HDR_LEN + ETH_PREAMBLE + ETH_CRC_LEN + ETH_802_1Q_LEN;
+    static const uint32_t ETH_MAX_FRAME_LEN    = ETH_MAX_RX_LEN + 1;
+
+    // Size of a control bitmap (one bit per byte) for a maximum length frame
+    static const uint32_t ETH_CTRL_MAP_LEN     = (ETH_MAX_FRAME_LEN + 7) / 8;
+
+    // Number of XGMII words for a maximum length frame, and for an encoded frame
+    // which may be preceded by up to ETH_IPG idle bytes and followed by an idle word
+    static const uint32_t ETH_MAX_XGMII_WORDS  = (ETH_MAX_FRAME_LEN + 7) / 8;
+    static const uint32_t ETH_MAX_ENC_WORDS    = (ETH_MAX_FRAME_LEN + ETH_IPG + 7) / 8 + 1;
+
+    // A 64 bit XGMII word of all idle characters
+    static const uint64_t IDLE_WORD            = 0x0707070707070707ULL;
+
+    // --------------------------------------------
+    // Type definitions
+    // --------------------------------------------
+
+    // An encoded XGMII word, in the order transferred to the HDL
+    typedef struct {
+        uint32_t   txd_lo;
+        uint32_t   txd_hi;
+        uint32_t   txc;
+    } xgmiiWord_t;
+
+    // Performance counts, since construction or the last TcpVpResetPerf()
+    typedef struct {
+        // Frames and bytes (without preamble) sent (handed to the HDL, in burst mode), and
+        // received without error
+        uint64_t   tx_frames;
+        uint64_t   tx_bytes;
+        uint64_t   rx_frames;
+        uint64_t   rx_bytes;
+
+        // Simulated clock ticks, and those with frame data on TX and RX (the rest being idle)
+        uint64_t   ticks;
+        uint64_t   tx_busy_ticks;
+        uint64_t   rx_busy_ticks;
+
+        // VProc accesses
+        uint64_t   vp_writes;
+        uint64_t   vp_reads;
+        uint64_t   vp_burst_writes;
+        uint64_t   vp_burst_reads;
+        uint64_t   vp_ticks;
+
+        // Wall clock time, and the part of it blocked in VProc accesses (the rest being
+        // in this code and the user's)
+        uint64_t   wall_ns;
+        uint64_t   vp_ns;
+    } tcpVpPerf_t;
 
     // --------------------------------------------
     // Constructor
     // --------------------------------------------
 
-    tcpVProc(int nodeIn) : node(nodeIn)
+    tcpVProc(int nodeIn) : node(nodeIn), tx_shaper(CLK10G_FREQ)
     {
         currTickCount                  = 0xffffffff;
         receiving_frame                = false;
         rx_idx                         = 0;
+        rx_ovfl_count                  = 0;
+        rx_frame_count                 = 0;
+        rx_draining                    = false;
+        rx_irq_mode                    = false;
+        tx_space                       = 0;
+        line_rate_tx                   = false;
+        tx_next_offset                 = 0;
+        tx_dic                         = 0;
+        tx_hold                        = false;
+        tx_held_words                  = 0;
+
+        memset(&perf, 0, sizeof(perf));
+        perf_start_tick                = 0;
+        perf_start_ns                  = TcpVpWallNs();
+        perf_timing                    = true;
+
+        // Default to burst transfers if the HDL has the VProc burst interface
+#ifdef VPROC_BURST_IF
+        burst_mode                     = true;
+#else
+        burst_mode                     = false;
+#endif
+    };
+
+    virtual ~tcpVProc()
+    {
+        if (rx_irq_mode && TcpVpIrqObj()[node] == this)
+        {
+            TcpVpIrqObj()[node]        = NULL;
+        }
     };
 
+    // --------------------------------------------------
+    // Method to select burst transfers, where whole
+    // frames are queued in the HDL TX FIFO, and received
+    // words fetched from the HDL RX buffer, with single
+    // burst accesses. Any RX words captured before
+    // enabling are discarded, and any queued TX frames
+    // are sent before disabling.
+    // --------------------------------------------------
+
+    void TcpVpSetBurstMode(bool enable)
+    {
+        if (enable && !burst_mode)
+        {
+            TcpVpWrite(RXCOUNT_ADDR, 0, true);
+            tx_space                   = 0;
+        }
+        else if (!enable && burst_mode)
+        {
+            TcpVpSetRxInterrupt(false);
+            TcpVpWaitTxEmpty();
+        }
+
+        burst_mode                     = enable;
+    }
+
+    bool TcpVpGetBurstMode(void) {return burst_mode;}
+
+    // --------------------------------------------------
+    // Method to select interrupt driven reception, where
+    // the HDL interrupts when complete frames are in its
+    // RX buffer, and a handler fetches them. Polling for
+    // received data is then not needed, so idling is a
+    // single access. Selects burst mode when enabled.
+    // --------------------------------------------------
+
+    void TcpVpSetRxInterrupt(bool enable)
+    {
+        if (enable == rx_irq_mode)
+        {
+            return;
+        }
+
+        if (node < 0 || node >= MAX_NODES)
+        {
+            printf("NODE%d: TcpVpSetRxInterrupt() : ***ERROR. Node number out of range for interrupts\n", node);
+            return;
+        }
+
+        if (enable)
+        {
+            TcpVpSetBurstMode(true);
+
+            TcpVpIrqObj()[node]        = this;
+            VRegInterrupt(RX_IRQ_LEVEL, TcpVpRxIsrTable()[node], node);
+        }
+
+        rx_irq_mode                    = enable;
+
+        TcpVpWrite(IRQEN_ADDR, enable ? 1 : 0, true);
+
+        // Fetch anything that completed before the interrupt was enabled
+        if (enable)
+        {
+            TcpVpDrainRx();
+        }
+    }
+
+    bool TcpVpGetRxInterrupt(void) {return rx_irq_mode;}
+
+    // --------------------------------------------------
+    // Method to select line rate transmission, where
+    // frames sent with TcpVpSendRawEthFrame() are packed
+    // back to back, rather than each padded to a word
+    // boundary and followed by an idle word. Each gap
+    // is the nominal inter-packet gap, shortened or
+    // lengthened so the next frame starts on lane 0 or
+    // lane 4, with a deficit idle count keeping the
+    // average gap nominal.
+    // --------------------------------------------------
+
+    void TcpVpSetLineRateTx(bool enable) {line_rate_tx = enable;}
+
+    bool TcpVpGetLineRateTx(void) {return line_rate_tx;}
+
+    // --------------------------------------------------
+    // Method to shape the frames sent by this node to
+    // rate_bps bits per second, with bursts of up to
+    // burst_bytes, counting each frame's bytes on the
+    // wire to the start of the next at the nominal gap
+    // (so 10Gbit/s is line rate). A rate of 0 disables
+    // shaping. Frames are timed as handed to the HDL.
+    // --------------------------------------------------
+
+    void TcpVpSetTxRate(uint64_t rate_bps, uint32_t burst_bytes) {tx_shaper.setRate(rate_bps, burst_bytes);}
+
+    uint64_t TcpVpGetTxRate(void) {return tx_shaper.getRate();}
+
+    // --------------------------------------------------
+    // Method to wait until a shaper allows a frame, of
+    // len bytes as generated (see TcpVpWireBytes()), to
+    // be sent, processing received data meanwhile, and
+    // take its tokens. Does nothing if the shaper is
+    // disabled.
+    // --------------------------------------------------
+
+    void TcpVpShapeFrame(tcpShaper &shaper, uint32_t len)
+    {
+        if (!shaper.enabled())
+        {
+            return;
+        }
+
+        uint32_t bytes = TcpVpWireBytes(len);
+        uint32_t now   = TcpVpGetTicks();
+
+        for (uint32_t wait = shaper.delay(now, bytes); wait; wait = shaper.delay(now, bytes))
+        {
+            TcpVpSendIdle(wait);
+            now        = TcpVpGetTicks();
+        }
+
+        shaper.send(now, bytes);
+    }
+
+    // Bytes on the wire for a generated frame of len bytes (from the start of frame delimiter to
+    // the end of frame delimiter), up to the start of the next frame after the nominal gap
+    static uint32_t TcpVpWireBytes(uint32_t len) {return len - 1 + ETH_IPG;}
+
+    // --------------------------------------------------
+    // Method to hold frames queued in the HDL TX FIFO in
+    // burst mode, rather than sending each as queued,
+    // until released, when they are all sent back to
+    // back. As queuing takes longer than sending, this
+    // lets a run of frames go out at line rate. Held
+    // frames are released early if the FIFO fills.
+    // --------------------------------------------------
+
+    void TcpVpHoldTx(bool hold)
+    {
+        tx_hold                        = hold;
+
+        if (!hold)
+        {
+            TcpVpReleaseTx();
+        }
+    }
+
+    // --------------------------------------------------
+    // Method to wait until all frames queued in the HDL
+    // TX FIFO have been sent, processing any received
+    // data meanwhile
+    // --------------------------------------------------
+
+    void TcpVpWaitTxEmpty(void)
+    {
+        uint32_t fill;
+
+        TcpVpReleaseTx();
+
+        TcpVpRead(TXSEND_ADDR, &fill, true);
+
+        while (fill)
+        {
+            TcpVpTick(fill);
+            TcpVpDrainRx();
+
+            TcpVpRead(TXSEND_ADDR, &fill, true);
+        }
+    }
 
     // --------------------------------------------------
     // Method to idle for specified number of cycles
@@ -91,75 +406,715 @@ public:
         uint32_t error = 0;
         uint32_t currTicks;
 
-        VWrite(TXD_LO_ADDR, 0x07070707, true, node);
-        VWrite(TXD_HI_ADDR, 0x07070707, true, node);
-        VWrite(TXC_ADDR,          0xff, true, node);
+        // With interrupt driven reception, the whole idle period is a single access
+        if (rx_irq_mode)
+        {
+            uint32_t fill;
+
+            TcpVpRead(TXSEND_ADDR, &fill, true);
+            TcpVpTick(ticks);
+
+            // As for TcpVpWaitIdle(), no gap is owed once the TX FIFO has drained with an
+            // idle word after, unless the handler has sent more meanwhile
+            if (ticks > fill)
+            {
+                TcpVpRead(TXSEND_ADDR, &fill, true);
+
+                if (fill == 0)
+                {
+                    TcpVpTxGapDone();
+                }
+            }
+
+            return error;
+        }
+
+        // In burst mode, wait on the HDL idle register, which returns early
+        // only to process received frames
+        if (burst_mode)
+        {
+            TcpVpWaitIdle(ticks);
+
+            return error;
+        }
+
+        TcpVpWrite(TXD_LO_ADDR, 0x07070707, true);
+        TcpVpWrite(TXD_HI_ADDR, 0x07070707, true);
+        TcpVpWrite(TXC_ADDR,          0xff, true);
 
         // Get start time
         for (int idx = 0; idx < ticks; idx++)
         {
-            VRead(TICKS_ADDR, &currTicks, true, node);
+            TcpVpRead(TICKS_ADDR, &currTicks, true);
 
             TcpVpExtractRx();
         }
 
+        // After an idle word, no gap is owed to the last frame sent
+        if (ticks)
+        {
+            TcpVpTxGapDone();
+        }
+
         return error;
     }
 
     // --------------------------------------------------
-    // Method to send a pre-prepared (raw) ethernet frame
+    // Method to wait until a frame is received and
+    // processed without error, returning in the cycle
+    // it is delivered, or until timeout_ticks have
+    // elapsed. Returns true if a frame was delivered.
     // --------------------------------------------------
-    uint32_t TcpVpSendRawEthFrame(uint32_t* frame, uint32_t len)
-    {
-        uint32_t error = 0;
-        uint32_t fidx  = 0;
 
-        uint32_t buf[3];
+    bool TcpVpWaitForRx(uint32_t timeout_ticks = WAIT_FOREVER)
+    {
+        uint32_t start_count = rx_frame_count;
+        bool     forever     = timeout_ticks == WAIT_FOREVER;
+        uint32_t currTicks;
 
-        // Construct 64 bit TXD words and associated TXC byte from frame data,
-        // flushed to 64 bit boundary
-        for (int widx = 0; widx < (len+7)/8; widx++)
+        // In burst mode, wait on the HDL idle register, which wakes when a frame arrives
+        if (burst_mode)
         {
-            buf[0] = buf[1] = buf[2] = 0;
-
-            // Take 8 TXD bytes and TXC bits and construct the word
-            for (int idx = 0; idx < 8; idx++)
+            while (forever || timeout_ticks)
             {
-                // If output index is less than frame length, construct using the frame data,
-                // else pad with idle.
-                if (fidx < len)
+                uint32_t blk       = (forever || timeout_ticks > MAX_IDLE_WAIT) ? MAX_IDLE_WAIT : timeout_ticks;
+                uint32_t remaining = TcpVpWaitIdle(blk, true);
+
+                if (rx_frame_count != start_count)
                 {
-                    buf[idx/4] |= (frame[fidx] & 0xff) << (8*(idx%4));
-                    buf[2]     |= frame[fidx++] & 0x100 ? (1 << idx): 0;
+                    return true;
                 }
-                else
+
+                timeout_ticks     -= forever ? 0 : blk - remaining;
+            }
+        }
+        // Otherwise check for a delivered frame on every tick
+        else
+        {
+            TcpVpWrite(TXD_LO_ADDR, 0x07070707, true);
+            TcpVpWrite(TXD_HI_ADDR, 0x07070707, true);
+            TcpVpWrite(TXC_ADDR,          0xff, true);
+
+            while (forever || timeout_ticks--)
+            {
+                TcpVpRead(TICKS_ADDR, &currTicks, true);
+
+                TcpVpExtractRx();
+                TcpVpTxGapDone();
+
+                if (rx_frame_count != start_count)
                 {
-                    buf[idx/4] |= 0x7 << (8*(idx%4));
-                    buf[2]     |= 1 << idx;
+                    return true;
                 }
             }
+        }
 
-            // After each TXD/TXC word is constructed, send it out
-            VWrite(TXD_LO_ADDR, buf[0], true, node);
-            VWrite(TXD_HI_ADDR, buf[1], true, node);
-            VWrite(TXC_ADDR,    buf[2], true, node);
+        return false;
+    }
 
-            // Extract RX data and advance tick
-            TcpVpExtractRx();
+    // --------------------------------------------------
+    // Method to encode a pre-prepared (raw) ethernet
+    // frame, as packed bytes, into XGMII words.
+    // Control characters are flagged in the ctl bitmap
+    // (bit idx%8 of ctl[idx/8] for byte idx), so each
+    // bitmap byte is the TXC of a word. If ctl is NULL,
+    // the first and last bytes are the start and end of
+    // frame delimiters and the rest are data, as
+    // generated by tcpIpPg::genTcpIpPkt. The frame starts
+    // after offset idle bytes (up to ETH_IPG), the last
+    // word is padded with idles, and, if idle_word is
+    // set, an idle word follows the frame as the gap to
+    // the next. The words buffer must be at least
+    // ETH_MAX_ENC_WORDS long. Returns the number of words.
+    // --------------------------------------------------
+    static uint32_t TcpVpEncodeFrame(const uint8_t* frame, uint32_t len, const uint8_t* ctl, xgmiiWord_t* words,
+                                     uint32_t offset = 0, bool idle_word = true)
+    {
+        uint32_t end   = offset + len;
+        uint32_t nword = (end + 7) / 8;
+        uint32_t whole = (offset + 7) / 8;
+        uint32_t widx;
+        uint64_t txd;
+
+        // Any words before the first whole word of frame bytes
+        for (widx = 0; widx < whole && widx < nword; widx++)
+        {
+            TcpVpEncodePartWord(frame, len, ctl, (int32_t)(widx*8) - (int32_t)offset, words[widx]);
         }
 
-        TcpVpSendIdle(1);
+        // Whole words are loaded directly from the frame, with the TXC from the bitmap
+        for (; widx < end / 8; widx++)
+        {
+            memcpy(&txd, &frame[widx*8 - offset], 8);
+            txd                        = TCP_VP_LANE_ORDER64(txd);
 
-        return error;
+            words[widx].txd_lo         = (uint32_t)txd;
+            words[widx].txd_hi         = (uint32_t)(txd >> 32);
+            words[widx].txc            = ctl ? TcpVpCtlBits(ctl, len, widx*8 - offset) : 0;
+        }
+
+        // A partial last word
+        for (; widx < nword; widx++)
+        {
+            TcpVpEncodePartWord(frame, len, ctl, (int32_t)(widx*8) - (int32_t)offset, words[widx]);
+        }
+
+        // Without a bitmap, flag the delimiters as control characters
+        if (!ctl && len)
+        {
+            words[offset/8].txc       |= 1 << (offset%8);
+            words[(end-1)/8].txc      |= 1 << ((end-1)%8);
+        }
+
+        // Follow the frame with an idle word
+        if (idle_word)
+        {
+            words[widx].txd_lo         = (uint32_t)IDLE_WORD;
+            words[widx].txd_hi         = (uint32_t)(IDLE_WORD >> 32);
+            words[widx].txc            = 0xff;
+            widx++;
+        }
+
+        return widx;
     }
-    
+
+    // --------------------------------------------------
+    // Method to send XGMII words, as encoded by
+    // TcpVpEncodeFrame(). Encoded frames may be kept and
+    // sent again with this method, to avoid re-encoding
+    // frames sent many times. They are not packed for
+    // line rate transmission, so any gap still owed to a
+    // packed frame is sent as an idle word first.
+    // --------------------------------------------------
+    uint32_t TcpVpSendEncodedFrame(const xgmiiWord_t* words, uint32_t nwords)
+    {
+        if (tx_next_offset)
+        {
+            xgmiiWord_t idle = {(uint32_t)IDLE_WORD, (uint32_t)(IDLE_WORD >> 32), 0xff};
+
+            TcpVpSendWords(&idle, 1);
+            TcpVpTxGapDone();
+        }
+
+        return TcpVpSendWords(words, nwords);
+    }
+
+    // --------------------------------------------------
+    // Method to send a pre-prepared (raw) ethernet frame,
+    // as packed bytes, with an optional control bitmap
+    // (see TcpVpEncodeFrame()).
+    // --------------------------------------------------
+    uint32_t TcpVpSendRawEthFrame(const uint8_t* frame, uint32_t len, const uint8_t* ctl = NULL)
+    {
+        xgmiiWord_t words[ETH_MAX_ENC_WORDS];
+
+        if (len > ETH_MAX_FRAME_LEN)
+        {
+            printf("NODE%d: TcpVpSendRawEthFrame() : ***ERROR. Frame length (%d) too big. Must be <= %d\n", node, len, ETH_MAX_FRAME_LEN);
+            return 1;
+        }
+
+        // Wait until the node's shaper allows the frame
+        TcpVpShapeFrame(tx_shaper, len);
+
+        // Count the frame without its preamble and end delimiter
+        perf.tx_frames++;
+        perf.tx_bytes += len - ETH_PREAMBLE - 1;
+
+        if (line_rate_tx)
+        {
+            return TcpVpSendWords(words, TcpVpPackFrame(frame, len, ctl, words));
+        }
+
+        return TcpVpSendEncodedFrame(words, TcpVpEncodeFrame(frame, len, ctl, words));
+    }
+
+    // --------------------------------------------------
+    // Method to send a pre-prepared (raw) ethernet frame
+    // with one byte per word and bit 8 as the control
+    // flag. Packs the frame and sends as bytes.
+    // --------------------------------------------------
+    uint32_t TcpVpSendRawEthFrame(uint32_t* frame, uint32_t len)
+    {
+        uint8_t bytes[ETH_MAX_FRAME_LEN];
+        uint8_t ctl[ETH_CTRL_MAP_LEN];
+
+        if (len > ETH_MAX_FRAME_LEN)
+        {
+            printf("NODE%d: TcpVpSendRawEthFrame() : ***ERROR. Frame length (%d) too big. Must be <= %d\n", node, len, ETH_MAX_FRAME_LEN);
+            return 1;
+        }
+
+        memset(ctl, 0, sizeof(ctl));
+
+        for (uint32_t idx = 0; idx < len; idx++)
+        {
+            bytes[idx]                 = frame[idx] & 0xff;
+            ctl[idx/8]                 |= (frame[idx] & CTRL_BIT) ? (1 << (idx%8)) : 0;
+        }
+
+        return TcpVpSendRawEthFrame(bytes, len, ctl);
+    }
+
     // --------------------------------------------------
     // Method to set the halt output signal
     // --------------------------------------------------
-    void TcpVpSetHalt(uint32_t val) {VWrite(HALT_ADDR, val & 0x1, false, node);}
+    void TcpVpSetHalt(uint32_t val) {TcpVpWrite(HALT_ADDR, val & 0x1, false);}
+
+    // --------------------------------------------------
+    // Method to get the HDL clock tick count, for timing
+    // in the test code
+    // --------------------------------------------------
+    uint32_t TcpVpGetTicks(void)
+    {
+        uint32_t ticks;
+
+        TcpVpRead(TICKS_ADDR, &ticks, true);
+
+        return ticks;
+    }
+
+    // --------------------------------------------------
+    // Methods to get the performance counts, with the
+    // tick count refreshed from the HDL, and to restart
+    // them from now.
+    // --------------------------------------------------
+    tcpVpPerf_t TcpVpGetPerf(void)
+    {
+        tcpVpPerf_t snapshot;
+        uint32_t    fill = 0;
+
+        TcpVpRead(TICKS_ADDR, &currTickCount, true);
+
+        // Words still queued (or held) in the HDL TX FIFO have not been on the wire yet
+        if (burst_mode)
+        {
+            TcpVpRead(TXSEND_ADDR, &fill, true);
+            fill += tx_held_words;
+        }
+
+        perf.ticks                     = (uint32_t)(currTickCount - perf_start_tick);
+        perf.wall_ns                   = TcpVpWallNs() - perf_start_ns;
+
+        snapshot                       = perf;
+        snapshot.tx_busy_ticks         = (perf.tx_busy_ticks > fill) ? perf.tx_busy_ticks - fill : 0;
+
+        return snapshot;
+    }
+
+    // Timing of the VProc accesses may be disabled where its cost is significant
+    // compared to the accesses (such as with a stub VProc)
+    void TcpVpSetPerfTiming(bool enable) {perf_timing = enable;}
+
+    void TcpVpResetPerf(void)
+    {
+        TcpVpRead(TICKS_ADDR, &currTickCount, true);
+
+        memset(&perf, 0, sizeof(perf));
+        perf_start_tick                = currTickCount;
+        perf_start_ns                  = TcpVpWallNs();
+    }
     
 private:
 
+    // --------------------------------------------------
+    // Wall clock time in ns, for performance counts
+    // --------------------------------------------------
+    static uint64_t TcpVpWallNs(void)
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // --------------------------------------------------
+    // Method to send XGMII words, queuing them in the HDL
+    // TX FIFO in burst mode, or else writing them to the
+    // TX output a tick at a time
+    // --------------------------------------------------
+    uint32_t TcpVpSendWords(const xgmiiWord_t* words, uint32_t nwords)
+    {
+        uint32_t error = 0;
+
+        if (burst_mode)
+        {
+            if (nwords > TXBUF_DEPTH - 1)
+            {
+                printf("NODE%d: TcpVpSendWords() : ***ERROR. Number of words (%d) too big. Must be <= %d\n", node, nwords, TXBUF_DEPTH - 1);
+                return 1;
+            }
+
+            // Wait for space in the TX FIFO, only refreshing the last known free
+            // space when it's insufficient (and sending any held words to make it)
+            while (tx_space < nwords)
+            {
+                TcpVpReleaseTx();
+                TcpVpRead(TXSPACE_ADDR, &tx_space, true);
+
+                if (tx_space < nwords)
+                {
+                    TcpVpTick(nwords - tx_space);
+                    TcpVpDrainRx();
+                }
+            }
+
+            // Queue the frame in the TX FIFO in one burst. The HDL sends it
+            // without further intervention, once committed.
+            TcpVpBurstWrite(TXBUF_ADDR, (void*)words, nwords * XGMII_BURST_WORDS);
+
+            tx_held_words += nwords;
+            tx_space      -= nwords;
+
+            if (!tx_hold)
+            {
+                TcpVpReleaseTx();
+            }
+
+            // Process anything received whilst queuing, unless the interrupt will do so
+            if (!rx_irq_mode)
+            {
+                TcpVpDrainRx();
+            }
+        }
+        else
+        {
+            for (uint32_t widx = 0; widx < nwords; widx++)
+            {
+                // Send out each TXD/TXC word
+                TcpVpWrite(TXD_LO_ADDR, words[widx].txd_lo, true);
+                TcpVpWrite(TXD_HI_ADDR, words[widx].txd_hi, true);
+                TcpVpWrite(TXC_ADDR,    words[widx].txc,    true);
+
+                // Extract RX data and advance tick
+                TcpVpExtractRx();
+            }
+
+            // After a frame packed without a trailing idle word, return the output to idle
+            // from the next tick, unless a following frame is written first
+            if (nwords && !TcpVpIsIdle(words[nwords-1]))
+            {
+                TcpVpWrite(TXD_LO_ADDR, 0x07070707, true);
+                TcpVpWrite(TXD_HI_ADDR, 0x07070707, true);
+                TcpVpWrite(TXC_ADDR,          0xff, true);
+            }
+        }
+
+        // Count the words with frame data, which excludes any leading or trailing idle word
+        perf.tx_busy_ticks += nwords - ((nwords && TcpVpIsIdle(words[0])) ? 1 : 0) -
+                                       ((nwords > 1 && TcpVpIsIdle(words[nwords-1])) ? 1 : 0);
+
+        return error;
+    }
+
+    // --------------------------------------------------
+    // Method to commit any words held in the HDL TX
+    // FIFO, to be sent
+    // --------------------------------------------------
+    void TcpVpReleaseTx(void)
+    {
+        if (tx_held_words)
+        {
+            TcpVpWrite(TXSEND_ADDR, tx_held_words, true);
+            tx_held_words = 0;
+        }
+    }
+
+    // --------------------------------------------------
+    // Method to encode a frame for line rate
+    // transmission, starting after the gap owed to the
+    // last frame packed, and with no trailing idle word.
+    // The gap owed to this frame is the nominal gap
+    // from its terminate character to the next lane 0 or
+    // lane 4, rounded down whilst the deficit idle count
+    // allows, else rounded up, paying off the deficit.
+    // --------------------------------------------------
+    uint32_t TcpVpPackFrame(const uint8_t* frame, uint32_t len, const uint8_t* ctl, xgmiiWord_t* words)
+    {
+        uint32_t nwords   = TcpVpEncodeFrame(frame, len, ctl, words, tx_next_offset, false);
+
+        // Lane of the terminate character, and the bytes by which the nominal gap overshoots a
+        // lane 0 or lane 4 start
+        uint32_t eof_lane = (tx_next_offset + len - 1) % 8;
+        uint32_t over     = (eof_lane + ETH_IPG) % 4;
+        uint32_t gap      = ETH_IPG;
+
+        if (over && tx_dic + over <= ETH_MAX_IDLE_DEFICIT)
+        {
+            gap          -= over;
+            tx_dic       += over;
+        }
+        else if (over)
+        {
+            gap          += 4 - over;
+            tx_dic       -= 4 - over;
+        }
+
+        // The gap runs from the terminate character, so the idle bytes owed at the start of the
+        // next word are what's left of it after this word
+        tx_next_offset    = eof_lane + gap - 8;
+
+        return nwords;
+    }
+
+    // --------------------------------------------------
+    // Method to clear the gap owed to the last frame
+    // packed, once the TX output has been idle for at
+    // least a word
+    // --------------------------------------------------
+    void TcpVpTxGapDone(void)
+    {
+        tx_next_offset    = 0;
+        tx_dic            = 0;
+    }
+
+    // --------------------------------------------------
+    // Method to get the control bitmap bits for the 8
+    // frame bytes from index first (which may be before
+    // the frame, with those bits clear)
+    // --------------------------------------------------
+    static uint32_t TcpVpCtlBits(const uint8_t* ctl, uint32_t len, int32_t first)
+    {
+        uint32_t shift = first & 7;
+        int32_t  bidx  = (first - (int32_t)shift) / 8;
+        uint32_t bits  = (bidx >= 0) ? ctl[bidx] >> shift : 0;
+
+        if (shift && (uint32_t)(bidx + 1) < (len + 7) / 8)
+        {
+            bits      |= ctl[bidx + 1] << (8 - shift);
+        }
+
+        return bits & 0xff;
+    }
+
+    // --------------------------------------------------
+    // Method to encode an XGMII word only partly of
+    // frame bytes, from frame index first (which may be
+    // before the frame), with the frame bytes loaded over
+    // an idle word and the TXC bits of the idle lanes set
+    // --------------------------------------------------
+    static void TcpVpEncodePartWord(const uint8_t* frame, uint32_t len, const uint8_t* ctl, int32_t first, xgmiiWord_t &word)
+    {
+        int32_t  lo    = (first < 0) ? 0 : first;
+        int32_t  hi    = (first + 8 > (int32_t)len) ? (int32_t)len : first + 8;
+        uint32_t lanes = 0;
+        uint64_t txd   = IDLE_WORD;
+
+        if (hi > lo)
+        {
+            memcpy((uint8_t*)&txd + (lo - first), &frame[lo], hi - lo);
+            lanes      = ((1 << (hi - lo)) - 1) << (lo - first);
+        }
+
+        txd            = TCP_VP_LANE_ORDER64(txd);
+
+        word.txd_lo    = (uint32_t)txd;
+        word.txd_hi    = (uint32_t)(txd >> 32);
+        word.txc       = (~lanes & 0xff) | (ctl ? (TcpVpCtlBits(ctl, len, first) & lanes) : 0);
+    }
+
+    // Whether an encoded word is all idle characters
+    static bool TcpVpIsIdle(const xgmiiWord_t &word)
+    {
+        return word.txc == 0xff && word.txd_lo == (uint32_t)IDLE_WORD && word.txd_hi == (uint32_t)(IDLE_WORD >> 32);
+    }
+
+    // --------------------------------------------------
+    // VProc access methods, counting the accesses and
+    // the time blocked in them
+    // --------------------------------------------------
+    void TcpVpWrite(uint32_t addr, uint32_t data, bool delta)
+    {
+        uint64_t start_ns = perf_timing ? TcpVpWallNs() : 0;
+        VWrite(addr, data, delta, node);
+        perf.vp_ns += perf_timing ? TcpVpWallNs() - start_ns : 0;
+        perf.vp_writes++;
+    }
+
+    void TcpVpRead(uint32_t addr, uint32_t* data, bool delta)
+    {
+        uint64_t start_ns = perf_timing ? TcpVpWallNs() : 0;
+        VRead(addr, data, delta, node);
+        perf.vp_ns += perf_timing ? TcpVpWallNs() - start_ns : 0;
+        perf.vp_reads++;
+    }
+
+    void TcpVpBurstWrite(uint32_t addr, void* data, uint32_t len)
+    {
+        uint64_t start_ns = perf_timing ? TcpVpWallNs() : 0;
+        VBurstWrite(addr, data, len, node);
+        perf.vp_ns += perf_timing ? TcpVpWallNs() - start_ns : 0;
+        perf.vp_burst_writes++;
+    }
+
+    void TcpVpBurstRead(uint32_t addr, void* data, uint32_t len)
+    {
+        uint64_t start_ns = perf_timing ? TcpVpWallNs() : 0;
+        VBurstRead(addr, data, len, node);
+        perf.vp_ns += perf_timing ? TcpVpWallNs() - start_ns : 0;
+        perf.vp_burst_reads++;
+    }
+
+    // --------------------------------------------------
+    // Method to advance time when in burst mode
+    // --------------------------------------------------
+    void TcpVpTick(uint32_t ticks)
+    {
+        if (currTickCount == 0xffffffff)
+        {
+            TcpVpRead(TICKS_ADDR, &currTickCount, true);
+        }
+
+        uint64_t start_ns = perf_timing ? TcpVpWallNs() : 0;
+        VTick(ticks, node);
+        perf.vp_ns += perf_timing ? TcpVpWallNs() - start_ns : 0;
+        perf.vp_ticks++;
+
+        currTickCount += ticks;
+    }
+
+    // --------------------------------------------------
+    // Method to wait for the specified number of ticks in
+    // burst mode, with a single wait access on the HDL
+    // idle register. The wait ends early when a frame is
+    // received, which is processed before continuing,
+    // unless wake_on_rx is set and the frame was
+    // delivered. Returns the ticks remaining.
+    // --------------------------------------------------
+    uint32_t TcpVpWaitIdle(uint32_t ticks, bool wake_on_rx = false)
+    {
+        uint32_t start_count = rx_frame_count;
+        uint32_t dummy;
+        uint32_t now;
+        uint32_t fill;
+
+        TcpVpRead(TICKS_ADDR, &now, true);
+        TcpVpRead(TXSEND_ADDR, &fill, true);
+
+        uint32_t deadline = now + ticks;
+
+        // Tick at which the last word committed to the TX FIFO is sent
+        uint32_t tx_done  = now + fill;
+
+        while (ticks)
+        {
+            TcpVpWrite(IDLE_ADDR, ticks, true);
+            TcpVpRead(IDLE_ADDR, &dummy, false);
+
+            TcpVpRead(TICKS_ADDR, &now, true);
+            currTickCount = now;
+
+            TcpVpDrainRx();
+
+            // Frames may have been sent when processing those received
+            TcpVpRead(TXSEND_ADDR, &fill, true);
+
+            if (fill)
+            {
+                TcpVpRead(TICKS_ADDR, &tx_done, true);
+                tx_done  += fill;
+            }
+
+            ticks = ((int32_t)(deadline - now) > 0) ? deadline - now : 0;
+
+            if (wake_on_rx && rx_frame_count != start_count)
+            {
+                break;
+            }
+        }
+
+        // Once the FIFO has drained, and an idle word has followed, no gap is owed
+        // to the last frame sent, as when idling a tick at a time
+        TcpVpRead(TICKS_ADDR, &now, true);
+
+        if ((int32_t)(now - tx_done) > 0)
+        {
+            TcpVpTxGapDone();
+        }
+
+        return ticks;
+    }
+
+    // --------------------------------------------------
+    // Method to fetch all the words captured in the HDL
+    // RX buffer, with burst reads, and process them.
+    // --------------------------------------------------
+    void TcpVpDrainRx ()
+    {
+        uint32_t status;
+        uint32_t rx[RX_BURST_LEN * XGMII_BURST_WORDS];
+
+        // The interrupt may occur during a drain's own accesses, so don't nest
+        if (rx_draining)
+        {
+            return;
+        }
+
+        rx_draining = true;
+
+        TcpVpRead(RXCOUNT_ADDR, &status, true);
+
+        // Warn if words were lost since the last drain
+        uint32_t ovfl  = status >> RXCOUNT_OVFL_SHIFT;
+        if (ovfl != rx_ovfl_count)
+        {
+            printf("NODE%d: TcpVpDrainRx() : WARNING: RX buffer overflowed. %d frame(s) dropped\n", node, (ovfl - rx_ovfl_count) & RXCOUNT_MASK);
+            rx_ovfl_count = ovfl;
+        }
+
+        uint32_t count = status & RXCOUNT_MASK;
+
+        while (count)
+        {
+            uint32_t blk = (count > RX_BURST_LEN) ? RX_BURST_LEN : count;
+
+            TcpVpBurstRead(RXBUF_ADDR, rx, blk * XGMII_BURST_WORDS);
+
+            for (uint32_t widx = 0; widx < blk; widx++)
+            {
+                uint32_t* word = &rx[widx * XGMII_BURST_WORDS];
+
+                TcpVpProcessRxWord((uint64_t)word[0] | ((uint64_t)word[1] << 32), word[2]);
+            }
+
+            count -= blk;
+        }
+
+        rx_draining = false;
+    }
+
+    // --------------------------------------------------
+    // Interrupt handling. VProc interrupt handlers have no
+    // arguments, so there is one per node, which drains
+    // the RX buffer of the object registered for it.
+    // --------------------------------------------------
+
+    typedef int (*pTcpVpIsr_t)(void);
+
+    static tcpVProc** TcpVpIrqObj (void)
+    {
+        static tcpVProc* obj[MAX_NODES];
+        return obj;
+    }
+
+    template<int NODE> static int TcpVpRxIsr (void)
+    {
+        if (TcpVpIrqObj()[NODE])
+        {
+            TcpVpIrqObj()[NODE]->TcpVpDrainRx();
+        }
+
+        return 0;
+    }
+
+    static const pTcpVpIsr_t* TcpVpRxIsrTable (void)
+    {
+        static const pTcpVpIsr_t isr[MAX_NODES] = {
+            TcpVpRxIsr<0>,  TcpVpRxIsr<1>,  TcpVpRxIsr<2>,  TcpVpRxIsr<3>,
+            TcpVpRxIsr<4>,  TcpVpRxIsr<5>,  TcpVpRxIsr<6>,  TcpVpRxIsr<7>,
+            TcpVpRxIsr<8>,  TcpVpRxIsr<9>,  TcpVpRxIsr<10>, TcpVpRxIsr<11>,
+            TcpVpRxIsr<12>, TcpVpRxIsr<13>, TcpVpRxIsr<14>, TcpVpRxIsr<15>
+        };
+        return isr;
+    }
+
     // --------------------------------------------------
     // Method to extract received data from VProc input
     // interface.
@@ -167,13 +1122,12 @@ private:
     void TcpVpExtractRx ()
     {
         uint32_t rx[3];
-        uint32_t clk_count;
 
         // If the current tick count is uninitialised, fetch clock tick count from the HDL,
         // else increment for each read cycle.
         if (currTickCount == 0xffffffff)
         {
-            VRead(TICKS_ADDR, &currTickCount, true, node);
+            TcpVpRead(TICKS_ADDR, &currTickCount, true);
         }
         else
         {
@@ -181,22 +1135,40 @@ private:
         }
 
         // Read the input pins: the 64 bits of data and 8 of control
-        VRead(TXD_LO_ADDR, &rx[0],     true, node);
-        VRead(TXD_HI_ADDR, &rx[1],     true, node);
-        VRead(TXC_ADDR   , &rx[2],     false, node);
+        TcpVpRead(TXD_LO_ADDR, &rx[0],     true);
+        TcpVpRead(TXD_HI_ADDR, &rx[1],     true);
+        TcpVpRead(TXC_ADDR   , &rx[2],     false);
 
         // Amalgamate inputs into single words
-        uint64_t rxd = (uint64_t)rx[0] | ((uint64_t)rx[1] << 32);
-        uint64_t rxc =  rx[2];
+        TcpVpProcessRxWord((uint64_t)rx[0] | ((uint64_t)rx[1] << 32), rx[2]);
+    }
 
+    // --------------------------------------------------
+    // Method to process a received XGMII word, extracting
+    // frames and passing them to processFrame().
+    // --------------------------------------------------
+    void TcpVpProcessRxWord (uint64_t rxd, uint64_t rxc)
+    {
         // Process the input unless completely idle
         if (!(rxd == 0x0707070707070707 && rxc == 0xff))
         {
+            perf.rx_busy_ticks++;
+
+            // A word of all data bytes within a frame, with room for it in the buffer,
+            // is stored whole
+            if (receiving_frame && rxc == 0 && rx_idx + 8 <= ETH_MAX_RX_LEN)
+            {
+                uint64_t lanes = TCP_VP_LANE_ORDER64(rxd);
+                memcpy(&rx_buf[rx_idx], &lanes, 8);
+                rx_idx        += 8;
+                return;
+            }
+
             // Scan through the input byte at a time
             for (int idx = 0; idx < 8; idx++)
             {
                 // Extract the data byte, with bit 8 as the control bit
-                uint32_t rxbyte = ((rxd >> (8 * idx)) & 0xff) | ((rxc & (1 << idx)) ? 0x100 : 0);
+                uint32_t rxbyte = ((rxd >> (8 * idx)) & 0xff) | ((rxc & (1 << idx)) ? CTRL_BIT : 0);
 
                 // If not receiving a frame already, and a start-of-frame detected,
                 // flag receiving and reset the RX buffer index
@@ -215,20 +1187,32 @@ private:
                     {
                         receiving_frame = false;
 
-                        // Process input, subtracting the preamble
-                        processFrame(&rx_buf[ETH_PREAMBLE], rx_idx-ETH_PREAMBLE);
+                        // A frame shorter than the minimum would leave stale header bytes
+                        // in the buffer from the last frame, so is dropped without processing
+                        if (rx_idx < ETH_PREAMBLE + ETH_MIN_FRAME_LEN)
+                        {
+                            dropRuntFrame();
+                        }
+                        // Process input, subtracting the preamble, and count if delivered
+                        else if (processFrame(&rx_buf[ETH_PREAMBLE], rx_idx-ETH_PREAMBLE) == 0)
+                        {
+                            rx_frame_count++;
+                            perf.rx_frames++;
+                            perf.rx_bytes += rx_idx-ETH_PREAMBLE;
+                        }
                     }
                     // Whilst receiving a frame, place it in the receive buffer
                     else
                     {
-                        if (rx_idx == (ETH_MTU + ETH_HDR_LEN + ETH_PREAMBLE + ETH_CRC_LEN + ETH_802_1Q_LEN))
+                        if (rx_idx == ETH_MAX_RX_LEN)
                         {
                             printf("WARNING: received packet of maximum size without an end-of-frame delimiter. Terminating packet\n");
                             receiving_frame = false;
                         }
                         else
                         {
-                            rx_buf[rx_idx++] = rxbyte;
+                            // Store the byte, without its control flag
+                            rx_buf[rx_idx++] = rxbyte & 0xff;
                         }
                     }
                 }
@@ -252,11 +1236,44 @@ private:
     // Clock tick count (nominally at 6.4ns) to give timing
     uint32_t       currTickCount;
 
+    // Burst transfer mode selected, last HDL RX buffer overflow count, and last
+    // known free HDL TX FIFO space
+    bool           burst_mode;
+    uint32_t       rx_ovfl_count;
+    uint32_t       tx_space;
+
+    // Line rate transmission selected, with the idle bytes owed to the last frame packed
+    // at the start of the next word, and the deficit idle count
+    bool           line_rate_tx;
+    uint32_t       tx_next_offset;
+    uint32_t       tx_dic;
+
+    // TX FIFO words held from sending, and whether holding
+    bool           tx_hold;
+    uint32_t       tx_held_words;
+
+    // Rate shaper for all the frames sent by the node
+    tcpShaper      tx_shaper;
+
+    // Count of frames processed without error
+    uint32_t       rx_frame_count;
+
+    // Performance counts, and the tick count and wall clock time they started from
+    tcpVpPerf_t    perf;
+    uint32_t       perf_start_tick;
+    uint64_t       perf_start_ns;
+    bool           perf_timing;
+
+    // Interrupt driven reception selected, and RX buffer drain in progress
+    bool           rx_irq_mode;
+    bool           rx_draining;
+
     // State flag to indicate actively receiving data
     bool           receiving_frame;
 
-    // Receive buffer and index. Buffer size is the maximum for largest payload, plus headers
-    uint32_t       rx_buf[ETH_MTU + ETH_HDR_LEN + ETH_PREAMBLE + ETH_CRC_LEN + ETH_802_1Q_LEN];
+    // Receive buffer of packed bytes, and index. Buffer size is the maximum for largest
+    // payload, plus headers
+    uint8_t        rx_buf[ETH_MAX_RX_LEN];
     uint32_t       rx_idx;
 
 };
@@ -0,0 +1,46 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// VProc user API for the mock VProc backend (tcpVpMock.cpp),
+// which models two tcp_ip_pg nodes connected back to back, as
+// in test/tb.v, in-process, so the test code runs without an
+// HDL simulator.
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _VUSER_H_
+#define _VUSER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define VPrint printf
+
+typedef int (*pVUserInt_t)(void);
+
+// Accesses with delta set complete without advancing the clock. Others, and
+// each word of a burst, take a clock cycle.
+extern int  VWrite        (unsigned addr, unsigned  data, int delta, uint32_t node);
+extern int  VRead         (unsigned addr, unsigned *data, int delta, uint32_t node);
+extern int  VBurstWrite   (unsigned addr, void* data, unsigned length, uint32_t node);
+extern int  VBurstRead    (unsigned addr, void* data, unsigned length, uint32_t node);
+extern int  VTick         (unsigned ticks, uint32_t node);
+extern void VRegInterrupt (int level, pVUserInt_t func, uint32_t node);
+
+#endif
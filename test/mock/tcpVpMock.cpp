@@ -0,0 +1,820 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Mock VProc backend, modelling two tcp_ip_pg nodes connected
+// back to back, in-process, with the VProc user API and a main
+// entry point to run the nodes' VUserMain<n> functions.
+//
+// Usage: tcpMock [timeout_ticks]
+//
+// Returns 0 if a node halted the run, and 1 if it timed out.
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+// The coroutines switch stacks with _longjmp, which the fortified version rejects
+#undef _FORTIFY_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "tcpVpMock.h"
+
+// User main functions for each node
+extern "C" void VUserMain0(void);
+extern "C" void VUserMain1(void);
+
+// The backend that the VProc user API accesses
+static tcpVpMock* mock                 = NULL;
+
+// --------------------------------------------------
+// Constructor, with the model state as the HDL's
+// initial block
+// --------------------------------------------------
+
+tcpVpMock::tcpVpMock (uint32_t timeoutIn) : count(0), timeout(timeoutIn), to_resume(0)
+{
+    for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+    {
+        node_t &n                      = nodes[idx];
+
+        n.txd_vp                       = IDLE_WORD;
+        n.txc_vp                       = 0xff;
+        n.rxd                          = IDLE_WORD;
+        n.rxc                          = 0xff;
+
+        n.tx_wr_stage                  = 0;
+        n.tx_wr_word                   = 0;
+        n.tx_wr_ptr                    = 0;
+        n.tx_commit_ptr                = 0;
+        n.tx_rd_ptr                    = 0;
+        n.tx_play_en                   = false;
+        n.txd_play                     = IDLE_WORD;
+        n.txc_play                     = 0xff;
+
+        n.rx_cap_wptr                  = 0;
+        n.rx_frm_wptr                  = 0;
+        n.rx_cap_rptr                  = 0;
+        n.rx_rd_word                   = 0;
+        n.rx_in_frame                  = false;
+        n.rx_dropping                  = false;
+        n.rx_ovfl_count                = 0;
+        n.rx_frm_count                 = 0;
+
+        n.rx_irq_en                    = false;
+        n.idle_deadline                = 0;
+        n.idle_frm_count               = 0;
+        n.halt                         = false;
+
+        n.wait_type                    = WAIT_NONE;
+        n.wait_until                   = 0;
+        n.in_isr                       = false;
+        n.finished                     = false;
+        n.user_main                    = NULL;
+        n.stack                        = NULL;
+#ifndef _WIN32
+        n.started                      = false;
+#endif
+
+        for (uint32_t level = 0; level < NUM_IRQ_LEVELS; level++)
+        {
+            n.isr[level]               = NULL;
+        }
+    }
+}
+
+// --------------------------------------------------
+// Run the nodes until one halts or the timeout is
+// reached. Only one coroutine runs at a time: each
+// node in turn, after each clock edge, until it waits
+// for a later edge, and then the run loop to model
+// the next edge. Edges where no node is due to run
+// are modelled without switching, as are those where
+// only the node waiting is (see waitEdge()).
+// --------------------------------------------------
+
+int tcpVpMock::run (const pVUserMain_t userMain[NUM_NODES])
+{
+#ifdef _WIN32
+    main_ctx                           = ConvertThreadToFiber(NULL);
+#endif
+
+    for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+    {
+        node_t &n                      = nodes[idx];
+
+        n.user_main                    = userMain[idx];
+
+#ifdef _WIN32
+        n.ctx                          = CreateFiber(NODE_STACK_SIZE, nodeEntry, (LPVOID)(uintptr_t)idx);
+#else
+        n.stack                        = new uint8_t[NODE_STACK_SIZE];
+
+        getcontext(&n.ctx);
+        n.ctx.uc_stack.ss_sp           = n.stack;
+        n.ctx.uc_stack.ss_size         = NODE_STACK_SIZE;
+        n.ctx.uc_link                  = NULL;
+        makecontext(&n.ctx, (void (*)(void))nodeEntry, 1, (int)idx);
+#endif
+    }
+
+    // Run each node up to its first clocked access
+    to_resume                          = (1 << NUM_NODES) - 1;
+
+    while (count != timeout)
+    {
+        // A node may have modelled the edge already, leaving the nodes due at it to run
+        if (to_resume == 0)
+        {
+            skipIdle();
+            clockEdge();
+            to_resume                  = dueNodes();
+        }
+
+        for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+        {
+            if (to_resume & (1 << idx))
+            {
+                to_resume             &= ~(1 << idx);
+                resumeNode(idx);
+            }
+        }
+
+        for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+        {
+            if (nodes[idx].halt)
+            {
+                return idx;
+            }
+        }
+    }
+
+    return -1;
+}
+
+// --------------------------------------------------
+// VProc user API methods
+// --------------------------------------------------
+
+int tcpVpMock::write (uint32_t node, uint32_t addr, uint32_t data, bool delta)
+{
+    access(node, addr, data, true);
+
+    if (!delta)
+    {
+        waitClock(node, WAIT_TICKS, 1);
+    }
+
+    return 0;
+}
+
+int tcpVpMock::read (uint32_t node, uint32_t addr, uint32_t* data, bool delta)
+{
+    *data                              = access(node, addr, 0, false);
+
+    // A read of the idle register isn't acknowledged until the idle deadline, or a frame
+    // is received
+    if (!delta)
+    {
+        waitClock(node, (addr == IDLE_ADDR) ? WAIT_IDLE : WAIT_TICKS, 1);
+    }
+
+    return 0;
+}
+
+int tcpVpMock::burstWrite (uint32_t node, uint32_t addr, const uint32_t* data, uint32_t len)
+{
+    node_t  &n                         = nodes[node];
+    uint32_t idx                       = 0;
+
+    // Whole TX FIFO entries, from the start of one, are stored in a single step, with
+    // any remaining words written as single accesses
+    if ((addr & BUF_ADDR_MASK) == TXBUF_ADDR && n.tx_wr_word == 0)
+    {
+        for (; idx + 3 <= len; idx += 3)
+        {
+            n.tx_wr_stage              = ((uint64_t)data[idx+1] << 32) | data[idx];
+            n.txmem_d[n.tx_wr_ptr]     = n.tx_wr_stage;
+            n.txmem_c[n.tx_wr_ptr]     = data[idx+2] & 0xff;
+            n.tx_wr_ptr                = (n.tx_wr_ptr + 1) & TXBUF_MASK;
+        }
+    }
+
+    for (; idx < len; idx++)
+    {
+        access(node, addr, data[idx], true);
+    }
+
+    waitClock(node, WAIT_TICKS, len);
+
+    return 0;
+}
+
+int tcpVpMock::burstRead (uint32_t node, uint32_t addr, uint32_t* data, uint32_t len)
+{
+    node_t  &n                         = nodes[node];
+    uint32_t idx                       = 0;
+
+    // Likewise, whole RX buffer entries are read in a single step
+    if ((addr & BUF_ADDR_MASK) == RXBUF_ADDR && n.rx_rd_word == 0)
+    {
+        for (; idx + 3 <= len; idx += 3)
+        {
+            data[idx]                  = (uint32_t)n.rxmem_d[n.rx_cap_rptr];
+            data[idx+1]                = (uint32_t)(n.rxmem_d[n.rx_cap_rptr] >> 32);
+            data[idx+2]                = n.rxmem_c[n.rx_cap_rptr];
+            n.rx_cap_rptr              = (n.rx_cap_rptr + 1) & RXBUF_MASK;
+        }
+    }
+
+    for (; idx < len; idx++)
+    {
+        data[idx]                      = access(node, addr, 0, false);
+    }
+
+    waitClock(node, WAIT_TICKS, len);
+
+    return 0;
+}
+
+int tcpVpMock::tick (uint32_t node, uint32_t ticks)
+{
+    if (ticks)
+    {
+        waitClock(node, WAIT_TICKS, ticks);
+    }
+
+    return 0;
+}
+
+void tcpVpMock::regInterrupt (uint32_t node, int level, pVUserInt_t func)
+{
+    if (level > 0 && level < (int)NUM_IRQ_LEVELS)
+    {
+        nodes[node].isr[level]         = func;
+    }
+}
+
+// --------------------------------------------------
+// Coroutine entry point for a node, running its user
+// main function. A coroutine can't return, so if the
+// function does, the node is left finished.
+// --------------------------------------------------
+
+#ifdef _WIN32
+VOID CALLBACK tcpVpMock::nodeEntry (LPVOID node)
+#else
+void tcpVpMock::nodeEntry (int node)
+#endif
+{
+    uint32_t idx                       = (uint32_t)(uintptr_t)node;
+
+    mock->nodes[idx].user_main();
+
+    mock->nodes[idx].finished          = true;
+
+    while (true)
+    {
+        mock->yieldNode(idx);
+    }
+}
+
+// --------------------------------------------------
+// Model a register access, as the tcp_ip_pg Update
+// process. Reads have we clear.
+// --------------------------------------------------
+
+uint32_t tcpVpMock::access (uint32_t node, uint32_t addr, uint32_t data, bool we)
+{
+    node_t  &n                         = nodes[node];
+    uint32_t data_in                   = 0;
+
+    // Writes to the TX buffer region are the next TXD low, TXD high and TXC words of
+    // the next FIFO entry
+    if ((addr & BUF_ADDR_MASK) == TXBUF_ADDR)
+    {
+        if (we)
+        {
+            switch (n.tx_wr_word)
+            {
+            case 0:
+                n.tx_wr_stage          = (n.tx_wr_stage & 0xffffffff00000000ULL) | data;
+                break;
+            case 1:
+                n.tx_wr_stage          = (n.tx_wr_stage & 0x00000000ffffffffULL) | ((uint64_t)data << 32);
+                break;
+            default:
+                n.txmem_d[n.tx_wr_ptr] = n.tx_wr_stage;
+                n.txmem_c[n.tx_wr_ptr] = data & 0xff;
+                n.tx_wr_ptr            = (n.tx_wr_ptr + 1) & TXBUF_MASK;
+                break;
+            }
+
+            n.tx_wr_word               = (n.tx_wr_word == 2) ? 0 : n.tx_wr_word + 1;
+        }
+    }
+    // Reads from the RX buffer region return the next RXD low, RXD high and RXC words
+    // of the oldest captured entry
+    else if ((addr & BUF_ADDR_MASK) == RXBUF_ADDR)
+    {
+        switch (n.rx_rd_word)
+        {
+        case 0:  data_in               = (uint32_t)n.rxmem_d[n.rx_cap_rptr];         break;
+        case 1:  data_in               = (uint32_t)(n.rxmem_d[n.rx_cap_rptr] >> 32); break;
+        default: data_in               = n.rxmem_c[n.rx_cap_rptr];                   break;
+        }
+
+        if (!we)
+        {
+            if (n.rx_rd_word == 2)
+            {
+                n.rx_cap_rptr          = (n.rx_cap_rptr + 1) & RXBUF_MASK;
+            }
+
+            n.rx_rd_word               = (n.rx_rd_word == 2) ? 0 : n.rx_rd_word + 1;
+        }
+    }
+    else
+    {
+        switch (addr)
+        {
+        // Update the TXD/TXC outputs, if a write, and read the RXD/RXC inputs
+        case TXD_LO_ADDR:
+            data_in                    = (uint32_t)n.rxd;
+            if (we)
+            {
+                n.txd_vp               = (n.txd_vp & 0xffffffff00000000ULL) | data;
+            }
+            break;
+
+        case TXD_HI_ADDR:
+            data_in                    = (uint32_t)(n.rxd >> 32);
+            if (we)
+            {
+                n.txd_vp               = (n.txd_vp & 0x00000000ffffffffULL) | ((uint64_t)data << 32);
+            }
+            break;
+
+        case TXC_ADDR:
+            data_in                    = n.rxc;
+            if (we)
+            {
+                n.txc_vp               = data & 0xff;
+            }
+            break;
+
+        case TICKS_ADDR:
+            data_in                    = count;
+            break;
+
+        case HLT_ADDR:
+            if (we)
+            {
+                n.halt                 = data & 1;
+            }
+            break;
+
+        // A write commits words written to the TX FIFO, discarding any others. A read
+        // returns the number of committed words still to be sent.
+        case TXSEND_ADDR:
+            data_in                    = (n.tx_commit_ptr - n.tx_rd_ptr) & TXBUF_MASK;
+            if (we)
+            {
+                n.tx_commit_ptr        = (n.tx_commit_ptr + data) & TXBUF_MASK;
+                n.tx_wr_ptr            = n.tx_commit_ptr;
+                n.tx_wr_word           = 0;
+            }
+            break;
+
+        case TXSPACE_ADDR:
+            data_in                    = (n.tx_rd_ptr - n.tx_wr_ptr - 1) & TXBUF_MASK;
+            break;
+
+        // A read returns the dropped frame count and the words of completed frames. A
+        // write discards all completed frames.
+        case RXCOUNT_ADDR:
+            data_in                    = ((uint32_t)n.rx_ovfl_count << 16) | rxCapCount(n);
+            if (we)
+            {
+                n.rx_cap_rptr          = n.rx_frm_wptr;
+                n.rx_rd_word           = 0;
+            }
+            break;
+
+        // A write sets the idle deadline to the given number of ticks from now. A read
+        // returns the ticks remaining.
+        case IDLE_ADDR:
+            data_in                    = n.idle_deadline - count;
+            if (we)
+            {
+                n.idle_deadline        = count + data;
+                n.idle_frm_count       = n.rx_frm_count;
+            }
+            break;
+
+        case IRQEN_ADDR:
+            data_in                    = n.rx_irq_en ? 1 : 0;
+            if (we)
+            {
+                n.rx_irq_en            = data & 1;
+            }
+            break;
+
+        default:
+            printf("***ERROR: tcp_ip_pg---access to invalid address (0x%08x) from node %d\n", addr, node);
+            exit(1);
+        }
+    }
+
+    return data_in;
+}
+
+// --------------------------------------------------
+// Model a clock edge, as the tcp_ip_pg clocked
+// processes, with each node's RX inputs connected to
+// the other's TX outputs
+// --------------------------------------------------
+
+void tcpVpMock::clockEdge (void)
+{
+    // Sample the RX inputs for all nodes before any outputs change
+    for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+    {
+        node_t &peer                   = nodes[(idx + 1) % NUM_NODES];
+
+        nodes[idx].rxd                 = peer.tx_play_en ? peer.txd_play : peer.txd_vp;
+        nodes[idx].rxc                 = peer.tx_play_en ? peer.txc_play : peer.txc_vp;
+    }
+
+    for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+    {
+        node_t &n                      = nodes[idx];
+
+        // Play out the next committed TX FIFO entry, if any
+        n.tx_play_en                   = false;
+
+        if (((n.tx_commit_ptr - n.tx_rd_ptr) & TXBUF_MASK) != 0)
+        {
+            n.txd_play                 = n.txmem_d[n.tx_rd_ptr];
+            n.txc_play                 = n.txmem_c[n.tx_rd_ptr];
+            n.tx_play_en               = true;
+            n.tx_rd_ptr                = (n.tx_rd_ptr + 1) & TXBUF_MASK;
+        }
+
+        // Capture RX frame words, from a start of frame to an end of frame or idle
+        bool rx_idle                   = n.rxd == IDLE_WORD && n.rxc == 0xff;
+        bool rx_sof                    = false;
+        bool rx_eof                    = false;
+
+        // A word of all data bytes has no delimiters to look for
+        for (uint32_t lane = 0; n.rxc != 0 && lane < 8; lane++)
+        {
+            uint8_t byte               = (n.rxd >> (lane * 8)) & 0xff;
+
+            rx_sof                    |= ((n.rxc >> lane) & 1) && byte == SOF_CHAR;
+            rx_eof                    |= ((n.rxc >> lane) & 1) && byte == EOF_CHAR;
+        }
+
+        if (n.rx_in_frame || rx_sof)
+        {
+            uint32_t wptr              = n.rx_cap_wptr;
+            bool     dropping          = n.rx_dropping;
+            bool     full              = ((wptr + 1) & RXBUF_MASK) == n.rx_cap_rptr;
+
+            // Store the word, unless the buffer is full or the frame is being dropped
+            if (!dropping)
+            {
+                if (!full)
+                {
+                    n.rxmem_d[wptr]    = n.rxd;
+                    n.rxmem_c[wptr]    = n.rxc;
+                    n.rx_cap_wptr      = (wptr + 1) & RXBUF_MASK;
+                }
+                else
+                {
+                    n.rx_cap_wptr      = n.rx_frm_wptr;
+                    n.rx_dropping      = true;
+                    n.rx_ovfl_count++;
+                }
+            }
+
+            // At the end of the frame, make the stored words available
+            if (n.rx_in_frame && (rx_eof || rx_idle))
+            {
+                n.rx_in_frame          = false;
+                n.rx_dropping          = false;
+
+                if (!dropping && !full)
+                {
+                    n.rx_frm_wptr      = (wptr + 1) & RXBUF_MASK;
+                    n.rx_frm_count++;
+                }
+            }
+            else
+            {
+                n.rx_in_frame          = true;
+            }
+        }
+    }
+
+    count++;
+}
+
+// --------------------------------------------------
+// Skip over clock edges while the links are idle, no
+// TX FIFO has words to send and no frame is being
+// captured, as the edges change nothing but the
+// tick count, up to the edge before the next one
+// where a node's wait ends
+// --------------------------------------------------
+
+void tcpVpMock::skipIdle (void)
+{
+    uint32_t skip                      = timeout - count - 1;
+
+    for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+    {
+        node_t &n                      = nodes[idx];
+
+        if (n.tx_play_en || n.tx_commit_ptr != n.tx_rd_ptr || n.txd_vp != IDLE_WORD || n.txc_vp != 0xff ||
+            n.rx_in_frame || n.rxd != IDLE_WORD || n.rxc != 0xff)
+        {
+            return;
+        }
+
+        if (!n.finished)
+        {
+            // An idle register read waits for its deadline unless already woken by a frame
+            uint32_t wake              = n.wait_until;
+
+            if (n.wait_type == WAIT_IDLE && rxCapCount(n) == 0 && n.rx_frm_count == n.idle_frm_count &&
+                (int32_t)(n.idle_deadline - wake) > 0)
+            {
+                wake                   = n.idle_deadline;
+            }
+
+            if ((int32_t)(wake - count) <= 0)
+            {
+                return;
+            }
+
+            skip                       = (wake - count - 1 < skip) ? wake - count - 1 : skip;
+        }
+    }
+
+    count                             += skip;
+}
+
+// --------------------------------------------------
+// Whether a node's wait is over at the current clock
+// edge. An idle register read is acknowledged at the
+// deadline, or when a frame has been received.
+// --------------------------------------------------
+
+bool tcpVpMock::waitDone (const node_t &n)
+{
+    bool elapsed                       = (int32_t)(count - n.wait_until) >= 0;
+
+    switch (n.wait_type)
+    {
+    case WAIT_TICKS:
+        return elapsed;
+
+    case WAIT_IDLE:
+        return elapsed && !((int32_t)(n.idle_deadline - count) > 0 && rxCapCount(n) == 0 &&
+                            n.rx_frm_count == n.idle_frm_count);
+
+    default:
+        return false;
+    }
+}
+
+// --------------------------------------------------
+// Mask of the nodes due to run at the current clock
+// edge: those whose wait is over, or with an
+// interrupt to handle
+// --------------------------------------------------
+
+uint32_t tcpVpMock::dueNodes (void)
+{
+    uint32_t due                       = 0;
+
+    for (uint32_t idx = 0; idx < NUM_NODES; idx++)
+    {
+        if (!nodes[idx].finished && (waitDone(nodes[idx]) || irqDue(nodes[idx])))
+        {
+            due                       |= 1 << idx;
+        }
+    }
+
+    return due;
+}
+
+// --------------------------------------------------
+// Suspend a node's user code until its wait is over.
+// If resumed earlier by an interrupt, the handler is
+// run (which may itself wait) before carrying on
+// waiting.
+// --------------------------------------------------
+
+void tcpVpMock::waitClock (uint32_t node, waitType_t type, uint32_t ticks)
+{
+    node_t  &n                         = nodes[node];
+    uint32_t until                     = count + ticks;
+
+    while (true)
+    {
+        n.wait_type                    = type;
+        n.wait_until                   = until;
+
+        waitEdge(node);
+
+        if (irqDue(n))
+        {
+            n.in_isr                   = true;
+            n.isr[irqLevel(n)]();
+            n.in_isr                   = false;
+
+            n.wait_type                = type;
+            n.wait_until               = until;
+        }
+
+        if (waitDone(n))
+        {
+            n.wait_type                = WAIT_NONE;
+            return;
+        }
+    }
+}
+
+// --------------------------------------------------
+// Wait for the next clock edge at which a node is
+// due to run. Whilst no other node is still to run
+// at the current edge, and no other is due at the
+// next, the edges are modelled here, as the run loop
+// would, without switching back to it. Otherwise,
+// the nodes due at the edge are left for the run
+// loop to run, in order.
+// --------------------------------------------------
+
+void tcpVpMock::waitEdge (uint32_t node)
+{
+    while (to_resume == 0 && count != timeout && !halted())
+    {
+        skipIdle();
+        clockEdge();
+
+        uint32_t due                   = dueNodes();
+
+        if (due & ~(1 << node))
+        {
+            to_resume                  = due;
+            break;
+        }
+
+        if (due)
+        {
+            return;
+        }
+    }
+
+    yieldNode(node);
+}
+
+// --------------------------------------------------
+// Switch to a node's user code until it waits, and
+// from a node's user code back to the run loop. A
+// node is started with swapcontext, and afterwards
+// switched with _setjmp/_longjmp.
+// --------------------------------------------------
+
+void tcpVpMock::resumeNode (uint32_t node)
+{
+#ifdef _WIN32
+    SwitchToFiber(nodes[node].ctx);
+#else
+    node_t &n                          = nodes[node];
+
+    if (!_setjmp(main_jmp))
+    {
+        if (n.started)
+        {
+            _longjmp(n.jmp, 1);
+        }
+
+        n.started                      = true;
+        swapcontext(&main_ctx, &n.ctx);
+    }
+#endif
+}
+
+void tcpVpMock::yieldNode (uint32_t node)
+{
+#ifdef _WIN32
+    SwitchToFiber(main_ctx);
+#else
+    if (!_setjmp(nodes[node].jmp))
+    {
+        _longjmp(main_jmp, 1);
+    }
+#endif
+}
+
+// --------------------------------------------------
+// VProc user API
+// --------------------------------------------------
+
+static bool validNode (uint32_t node)
+{
+    if (mock == NULL || node >= tcpVpMock::NUM_NODES)
+    {
+        printf("***ERROR: VProc access from invalid node %d\n", node);
+        return false;
+    }
+
+    return true;
+}
+
+extern "C" int VWrite (unsigned addr, unsigned data, int delta, uint32_t node)
+{
+    return validNode(node) ? mock->write(node, addr, data, delta != 0) : 1;
+}
+
+extern "C" int VRead (unsigned addr, unsigned *data, int delta, uint32_t node)
+{
+    return validNode(node) ? mock->read(node, addr, (uint32_t*)data, delta != 0) : 1;
+}
+
+extern "C" int VBurstWrite (unsigned addr, void* data, unsigned length, uint32_t node)
+{
+    return validNode(node) ? mock->burstWrite(node, addr, (const uint32_t*)data, length) : 1;
+}
+
+extern "C" int VBurstRead (unsigned addr, void* data, unsigned length, uint32_t node)
+{
+    return validNode(node) ? mock->burstRead(node, addr, (uint32_t*)data, length) : 1;
+}
+
+extern "C" int VTick (unsigned ticks, uint32_t node)
+{
+    return validNode(node) ? mock->tick(node, ticks) : 1;
+}
+
+extern "C" void VRegInterrupt (int level, pVUserInt_t func, uint32_t node)
+{
+    if (validNode(node))
+    {
+        mock->regInterrupt(node, level, func);
+    }
+}
+
+// --------------------------------------------------
+// Main entry point
+// --------------------------------------------------
+
+int main (int argc, char** argv)
+{
+    static const tcpVpMock::pVUserMain_t userMain[tcpVpMock::NUM_NODES] = {VUserMain0, VUserMain1};
+
+    uint32_t timeout                   = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : tcpVpMock::DEFAULT_TIMEOUT;
+
+    // The nodes are left suspended when the run ends, so the backend is not deleted
+    mock                               = new tcpVpMock(timeout);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    int halt_node                      = mock->run(userMain);
+
+    double secs                        = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (halt_node < 0)
+    {
+        printf("\n***ERROR: timed out at tick %u\n", mock->ticks());
+    }
+    else
+    {
+        printf("\nHalted by node %d at tick %u\n", halt_node, mock->ticks());
+    }
+
+    printf("%.3f seconds, %.2f million ticks per second\n", secs, mock->ticks() / secs / 1e6);
+
+    fflush(stdout);
+
+    return (halt_node < 0) ? 1 : 0;
+}
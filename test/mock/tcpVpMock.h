@@ -0,0 +1,262 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class for a mock VProc backend, modelling the tcp_ip_pg HDL
+// registers, TX FIFO, RX buffer, tick counter and halt output
+// for two nodes, with the XGMII interfaces connected back to
+// back (as test/tb.v), and running each node's VUserMain<n>
+// as a coroutine, in lock step with the modelled clock.
+// Clock edges at which only the running node is due to run
+// are modelled without leaving its coroutine.
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_VP_MOCK_H_
+#define _TCP_VP_MOCK_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <setjmp.h>
+#endif
+
+extern "C" {
+#include "VUser.h"
+}
+
+class tcpVpMock
+{
+public:
+
+    // --------------------------------------------
+    // Static constants
+    // --------------------------------------------
+
+    // Number of nodes, and the default timeout (as test/tb.v) in clock ticks
+    static const uint32_t NUM_NODES            = 2;
+    static const uint32_t DEFAULT_TIMEOUT      = 400000;
+
+    // tcp_ip_pg register addresses
+    static const uint32_t TXD_LO_ADDR          = 0;
+    static const uint32_t TXD_HI_ADDR          = 1;
+    static const uint32_t TXC_ADDR             = 2;
+    static const uint32_t TICKS_ADDR           = 3;
+    static const uint32_t HLT_ADDR             = 4;
+    static const uint32_t TXSEND_ADDR          = 5;
+    static const uint32_t RXCOUNT_ADDR         = 6;
+    static const uint32_t TXSPACE_ADDR         = 7;
+    static const uint32_t IRQEN_ADDR           = 8;
+    static const uint32_t IDLE_ADDR            = 9;
+    static const uint32_t TXBUF_ADDR           = 0x10000;
+    static const uint32_t RXBUF_ADDR           = 0x20000;
+    static const uint32_t BUF_ADDR_MASK        = 0xffff0000;
+
+    // tcp_ip_pg TX FIFO and RX buffer depths, as pointer widths
+    static const uint32_t TXBUF_ADDR_BITS      = 11;
+    static const uint32_t RXBUF_ADDR_BITS      = 10;
+    static const uint32_t TXBUF_DEPTH          = 1 << TXBUF_ADDR_BITS;
+    static const uint32_t RXBUF_DEPTH          = 1 << RXBUF_ADDR_BITS;
+    static const uint32_t TXBUF_MASK           = TXBUF_DEPTH - 1;
+    static const uint32_t RXBUF_MASK           = RXBUF_DEPTH - 1;
+
+    // XGMII idle word and control characters
+    static const uint64_t IDLE_WORD            = 0x0707070707070707ULL;
+    static const uint8_t  SOF_CHAR             = 0xfb;
+    static const uint8_t  EOF_CHAR             = 0xfd;
+
+    // Number of VProc interrupt levels
+    static const uint32_t NUM_IRQ_LEVELS       = 8;
+
+    // Stack size for each node's user code
+    static const uint32_t NODE_STACK_SIZE      = 8*1024*1024;
+
+    // --------------------------------------------
+    // Type definitions
+    // --------------------------------------------
+
+    typedef void (*pVUserMain_t)(void);
+
+    // --------------------------------------------
+    // Constructor
+    // --------------------------------------------
+
+    tcpVpMock (uint32_t timeoutIn = DEFAULT_TIMEOUT);
+
+    // --------------------------------------------
+    // Public methods
+    // --------------------------------------------
+
+    // Run the nodes, each calling its user main function, until a node sets its halt
+    // output or the timeout is reached. Returns the halting node, or -1 on timeout.
+    int            run                 (const pVUserMain_t userMain[NUM_NODES]);
+
+    // Clock ticks since the start of the run
+    uint32_t       ticks               (void) {return count;};
+
+    // VProc user API, called from the nodes' user code
+    int            write               (uint32_t node, uint32_t addr, uint32_t data, bool delta);
+    int            read                (uint32_t node, uint32_t addr, uint32_t* data, bool delta);
+    int            burstWrite          (uint32_t node, uint32_t addr, const uint32_t* data, uint32_t len);
+    int            burstRead           (uint32_t node, uint32_t addr, uint32_t* data, uint32_t len);
+    int            tick                (uint32_t node, uint32_t ticks);
+    void           regInterrupt        (uint32_t node, int level, pVUserInt_t func);
+
+private:
+
+    // --------------------------------------------
+    // Private type definitions
+    // --------------------------------------------
+
+    // What a node's user code is waiting for
+    typedef enum {
+        WAIT_NONE,
+        WAIT_TICKS,
+        WAIT_IDLE
+    } waitType_t;
+
+    // Execution context of a coroutine
+#ifdef _WIN32
+    typedef LPVOID     context_t;
+#else
+    typedef ucontext_t context_t;
+#endif
+
+    // State of a node's tcp_ip_pg model, and of its user code coroutine
+    typedef struct {
+        // Registered TX outputs, and sampled RX inputs
+        uint64_t       txd_vp;
+        uint8_t        txc_vp;
+        uint64_t       rxd;
+        uint8_t        rxc;
+
+        // TX FIFO, with partly written entry, and the word being played out from it
+        uint64_t       txmem_d[TXBUF_DEPTH];
+        uint8_t        txmem_c[TXBUF_DEPTH];
+        uint64_t       tx_wr_stage;
+        uint32_t       tx_wr_word;
+        uint32_t       tx_wr_ptr;
+        uint32_t       tx_commit_ptr;
+        uint32_t       tx_rd_ptr;
+        bool           tx_play_en;
+        uint64_t       txd_play;
+        uint8_t        txc_play;
+
+        // RX buffer of captured frame words
+        uint64_t       rxmem_d[RXBUF_DEPTH];
+        uint8_t        rxmem_c[RXBUF_DEPTH];
+        uint32_t       rx_cap_wptr;
+        uint32_t       rx_frm_wptr;
+        uint32_t       rx_cap_rptr;
+        uint32_t       rx_rd_word;
+        bool           rx_in_frame;
+        bool           rx_dropping;
+        uint16_t       rx_ovfl_count;
+        uint16_t       rx_frm_count;
+
+        // Interrupt enable, idle wait deadline and halt output
+        bool           rx_irq_en;
+        uint32_t       idle_deadline;
+        uint16_t       idle_frm_count;
+        bool           halt;
+
+        // Coroutine state: what it's waiting for, and until when, registered interrupt
+        // handlers, and whether in a handler or finished
+        waitType_t     wait_type;
+        uint32_t       wait_until;
+        pVUserInt_t    isr[NUM_IRQ_LEVELS];
+        bool           in_isr;
+        bool           finished;
+
+        // User main function, and coroutine context and stack. Once started, a coroutine
+        // is switched to and from with _setjmp/_longjmp, which, unlike swapcontext, don't
+        // make a system call to save and restore the signal mask.
+        pVUserMain_t   user_main;
+        context_t      ctx;
+        uint8_t*       stack;
+#ifndef _WIN32
+        jmp_buf        jmp;
+        bool           started;
+#endif
+    } node_t;
+
+    // --------------------------------------------
+    // Private methods
+    // --------------------------------------------
+
+    // Coroutine entry point for a node
+#ifdef _WIN32
+    static VOID CALLBACK nodeEntry     (LPVOID node);
+#else
+    static void    nodeEntry           (int node);
+#endif
+
+    // Model a register access, as the tcp_ip_pg Update process, returning the read data
+    uint32_t       access              (uint32_t node, uint32_t addr, uint32_t data, bool we);
+
+    // Model a clock edge for all the nodes
+    void           clockEdge           (void);
+
+    // Skip over clock edges where no state would change, up to the next one where a
+    // node is due to run
+    void           skipIdle            (void);
+
+    // Node status at the current clock edge, and the mask of nodes due to run at it
+    uint32_t       rxCapCount          (const node_t &n) {return (n.rx_frm_wptr - n.rx_cap_rptr) & RXBUF_MASK;};
+    uint32_t       irqLevel            (const node_t &n) {return (n.rx_irq_en && rxCapCount(n) != 0) ? 1 : 0;};
+    bool           waitDone            (const node_t &n);
+    bool           irqDue              (const node_t &n) {return !n.in_isr && irqLevel(n) && n.isr[irqLevel(n)];};
+    uint32_t       dueNodes            (void);
+    bool           halted              (void) {for (uint32_t idx = 0; idx < NUM_NODES; idx++) {if (nodes[idx].halt) return true;} return false;};
+
+    // Suspend a node's user code until its wait is over, running interrupt handlers meanwhile
+    void           waitClock           (uint32_t node, waitType_t type, uint32_t ticks);
+
+    // Suspend a node's user code until it is next due to run, modelling the clock edges
+    // without switching while no other node is due
+    void           waitEdge            (uint32_t node);
+
+    // Switch to a node's user code until it next waits, and back again
+    void           resumeNode          (uint32_t node);
+    void           yieldNode           (uint32_t node);
+
+    // --------------------------------------------
+    // Private member variables
+    // --------------------------------------------
+
+    node_t         nodes[NUM_NODES];
+
+    // Clock tick count and timeout
+    uint32_t       count;
+    uint32_t       timeout;
+
+    // Mask of the nodes still to be run at the current clock edge
+    uint32_t       to_resume;
+
+    // Context of the run loop, switched back to when a node waits or finishes
+    context_t      main_ctx;
+#ifndef _WIN32
+    jmp_buf        main_jmp;
+#endif
+};
+
+#endif
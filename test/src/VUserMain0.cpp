@@ -25,7 +25,7 @@
 #include <stdlib.h>
 
 #include "VUserMain.h"
-#include "tcptest0.h"
+#include "tcpTest0.h"
 
 // I'm node 0
 static int node = 0;
@@ -45,9 +45,15 @@ extern "C" void VUserMain0()
 
     tcpTest0* pTest = new tcpTest0(0);
 
-    pTest->runTest();
-
-    pTest->haltSim();
+    // The simulation is only halted if the test passed, so a failure runs on to the timeout
+    if (pTest->runTest() == 0)
+    {
+        pTest->haltSim();
+    }
+    else
+    {
+        VPrint("***ERROR: test failed at node %d\n", node);
+    }
     
     pTest->sleepForever();
 }
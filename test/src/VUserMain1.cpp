@@ -46,6 +46,9 @@ extern "C" void VUserMain1()
     tcpTest1* pTest = new tcpTest1(node);
     
     pTest->runTest();
+
+    // Node 0 halts the simulation, so write this node's counts before idling
+    pTest->writePerf();
     
     pTest->sleepForever();
 
@@ -0,0 +1,59 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// User entry points for the streaming test, in place of
+// VUserMain0.cpp and VUserMain1.cpp: node 0 streams frames to
+// node 1, which halts the simulation once all are received
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "VUserMain.h"
+#include "tcpStream.h"
+
+extern "C" void VUserMain0()
+{
+    tcpStream0* pTest = new tcpStream0(0);
+
+    if (pTest->runTest() != 0)
+    {
+        VPrint("***ERROR: test failed at node 0\n");
+    }
+
+    pTest->sleepForever();
+}
+
+extern "C" void VUserMain1()
+{
+    tcpStream1* pTest = new tcpStream1(1);
+
+    // The simulation is only halted if the test passed, so a failure runs on to the timeout
+    if (pTest->runTest() == 0)
+    {
+        pTest->haltSim();
+    }
+    else
+    {
+        VPrint("***ERROR: test failed at node 1\n");
+    }
+
+    pTest->sleepForever();
+}
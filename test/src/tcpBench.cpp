@@ -0,0 +1,350 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Microbenchmarks for the tcpIpPg packet generation and
+// reception code, built against the stub VProc API (with the
+// TXD/TXC registers looped back) so no simulator is needed.
+//
+// Usage: tcpBench [iterations]
+//
+// Output is CSV, one line per benchmark and payload size, with
+// the frame bytes counted from destination MAC to CRC.
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "tcpIpPg.h"
+
+// Node addresses. Frames are addressed to the benchmark's own node, as the stub loops them back.
+static const uint32_t IPV4_ADDR          = 0xc0a81908;
+static const uint64_t MAC_ADDR           = 0xd89ef3887ec3ULL;
+static const uint32_t TCP_PORT           = 0x400;
+
+static const uint32_t DEFAULT_ITERATIONS = 20000;
+
+// Number of flows in the flow table benchmark, each from its own source port
+static const uint32_t NUM_FLOWS          = 256;
+static const uint32_t FLOW_PORT_BASE     = 0x1000;
+
+// Payload sizes measured, up to the maximum TCP payload for the (non-jumbo) MTU
+static const uint32_t payload_sizes[]    = {0, 64, 128, 256, 512, 1024, 1460};
+
+// Sink for results, so the calculations aren't optimised away
+static volatile uint32_t sink;
+
+// Count of frames received by the view callback, and by the flows' view callback
+static uint32_t rx_count;
+static uint32_t flow_rx_count;
+
+// ---------------------------------------------
+// Receive view callback, counting frames
+// ---------------------------------------------
+
+static void rxViewCallback (const tcpIpPg::rxHdr_t* rx_hdr, const tcpIpPg::rxView_t* rx_view, void* hdl)
+{
+    rx_count++;
+    sink                                 = rx_view->payload_len;
+}
+
+// ---------------------------------------------
+// Flows' receive view callback, counting frames
+// ---------------------------------------------
+
+static void flowRxViewCallback (const tcpIpPg::rxHdr_t* rx_hdr, const tcpIpPg::rxView_t* rx_view, void* hdl)
+{
+    flow_rx_count++;
+    sink                                 = rx_view->payload_len;
+}
+
+// ---------------------------------------------
+// Wall clock time in ns
+// ---------------------------------------------
+
+static uint64_t wallNs (void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------
+// Output a benchmark result line
+// ---------------------------------------------
+
+static void report (const char* name, uint32_t payload_len, uint32_t frame_len, uint32_t iterations, uint64_t ns)
+{
+    double ns_per_frame                  = (double)ns / iterations;
+
+    printf("%s,%d,%d,%d,%.1f,%.3f\n", name, payload_len, frame_len, iterations, ns_per_frame, (double)frame_len * 8 / ns_per_frame);
+}
+
+// ---------------------------------------------
+// Main entry point
+// ---------------------------------------------
+
+int main (int argc, char** argv)
+{
+    uint32_t iterations                  = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_ITERATIONS;
+    int      error                       = 0;
+
+    static uint8_t payload[tcpIpPg::ETH_MTU];
+    static uint8_t frm_buf[tcpIpPg::ETH_MAX_FRAME_LEN];
+    static uint8_t flow_frm_buf[NUM_FLOWS][tcpIpPg::ETH_MAX_FRAME_LEN];
+    uint32_t       flow_len[NUM_FLOWS];
+    uint64_t       flow_frames[NUM_FLOWS];
+    uint64_t       flow_bytes[NUM_FLOWS];
+
+    tcpIpPg::xgmiiWord_t words[tcpIpPg::ETH_MAX_ENC_WORDS];
+
+    tcpIpPg*     pTcp                    = new tcpIpPg(0, IPV4_ADDR, MAC_ADDR, TCP_PORT);
+    tcpCrc32     crc;
+
+    pTcp->registerUsrRxViewCbFunc(rxViewCallback, NULL);
+
+    // The stub's accesses are too quick for their timing to be worthwhile
+    pTcp->TcpVpSetPerfTiming(false);
+
+    // Count any dropped frames without logging them
+    pTcp->setRxLogMode(tcpIpPg::RX_LOG_SUMMARY);
+
+    // Check the CRC engines against the bitwise reference, before timing the one selected
+    if (pTcp->crcSelfTest(true) != 0)
+    {
+        fprintf(stderr, "***ERROR: CRC engine self-test failed\n");
+        error                            = 1;
+    }
+
+    // Likewise check the checksum kernels against the byte at a time reference
+    if (tcpChksum::selfTest(true) != 0)
+    {
+        fprintf(stderr, "***ERROR: checksum kernel self-test failed\n");
+        error                            = 1;
+    }
+
+    // And the flow table's removal of flows from shared probe sequences
+    if (tcpIpPg::flowTable_t::selfTest(true) != 0)
+    {
+        fprintf(stderr, "***ERROR: flow table self-test failed\n");
+        error                            = 1;
+    }
+
+    for (uint32_t idx = 0; idx < sizeof(payload); idx++)
+    {
+        payload[idx]                     = idx;
+    }
+
+    tcpIpPg::tcpConfig_t cfg;
+
+    cfg.dst_port                         = TCP_PORT;
+    cfg.seq_num                          = 0;
+    cfg.ack_num                          = 0;
+    cfg.ack                              = true;
+    cfg.rst_conn                         = false;
+    cfg.sync_seq                         = false;
+    cfg.finish                           = false;
+    cfg.win_size                         = 32768;
+    cfg.ip_dst_addr                      = IPV4_ADDR;
+    cfg.mac_dst_addr                     = MAC_ADDR;
+
+    tcpIpPg::tcpFlowTemplate_t tmpl;
+    pTcp->initFlowTemplate(tmpl, cfg);
+
+    // Flows from each of the flow benchmark's source ports, looped back to the node's port,
+    // in a table sized for just these
+    pTcp->setMaxFlows(NUM_FLOWS);
+
+    for (uint32_t fidx = 0; fidx < NUM_FLOWS; fidx++)
+    {
+        pTcp->addFlow(IPV4_ADDR, FLOW_PORT_BASE + fidx, TCP_PORT, NULL, NULL, flowRxViewCallback);
+    }
+
+    printf("bench,payload_bytes,frame_bytes,iterations,ns_per_frame,gbps\n");
+
+    for (uint32_t sidx = 0; sidx < sizeof(payload_sizes)/sizeof(payload_sizes[0]); sidx++)
+    {
+        uint32_t payload_len             = payload_sizes[sidx];
+        uint64_t start;
+
+        // Frame length with preamble and end delimiter, and without
+        uint32_t len                     = pTcp->genTcpIpPkt(cfg, frm_buf, payload, payload_len);
+        uint32_t frame_len               = len - tcpIpPg::ETH_PREAMBLE - 1;
+        uint8_t* frame                   = &frm_buf[tcpIpPg::ETH_PREAMBLE];
+
+        // Frame generation, copying the payload
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            cfg.seq_num                  += payload_len;
+            sink                         = pTcp->genTcpIpPkt(cfg, frm_buf, payload, payload_len);
+        }
+        report("gen", payload_len, frame_len, iterations, wallNs() - start);
+
+        // Frame generation from a flow template, with the payload already in place
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            cfg.seq_num                  += payload_len;
+            sink                         = pTcp->genTcpIpPkt(tmpl, cfg, frm_buf, payload_len);
+        }
+        report("gen_tmpl", payload_len, frame_len, iterations, wallNs() - start);
+
+        // CRC over the frame
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            sink                         = crc.calc(frame, frame_len - tcpIpPg::ETH_CRC_LEN);
+        }
+        report("crc32", payload_len, frame_len, iterations, wallNs() - start);
+
+        // Checksum over the TCP segment
+        uint8_t* tcp_seg                 = &frame[tcpIpPg::ETH_HDR_LEN + tcpIpPg::IPV4_MIN_HDR_LEN*4];
+        uint32_t tcp_seg_len             = tcpIpPg::TCP_MIN_HDR_LEN*4 + payload_len;
+
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            sink                         = tcpChksum::sum(tcp_seg, tcp_seg_len);
+        }
+        report("chksum", payload_len, frame_len, iterations, wallNs() - start);
+
+        // Encoding the frame into XGMII words
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            sink                         = tcpIpPg::TcpVpEncodeFrame(frm_buf, len, NULL, words);
+        }
+        report("encode", payload_len, frame_len, iterations, wallNs() - start);
+
+        // Sending the frame, looped back by the stub, and receiving it: word encoding and
+        // decoding and frame processing, with the stub's register accesses
+        rx_count                         = 0;
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+        }
+        report("loopback_rx", payload_len, frame_len, iterations, wallNs() - start);
+
+        // The last frame is still being received when sending stops, as the frame is
+        // delivered on the trailing idle word read back with the next send
+        if (rx_count < iterations - 1)
+        {
+            fprintf(stderr, "***ERROR: only %d of %d looped back frames received\n", rx_count, iterations);
+            error                        = 1;
+        }
+
+        // Receiving frames for each of the flows in turn, demultiplexed by the flow table
+        for (uint32_t fidx = 0; fidx < NUM_FLOWS; fidx++)
+        {
+            tcpIpPg::tcpFlowTemplate_t flow_tmpl;
+
+            pTcp->initFlowTemplate(flow_tmpl, cfg, FLOW_PORT_BASE + fidx);
+            memcpy(pTcp->getPayloadPtr(flow_frm_buf[fidx]), payload, payload_len);
+            flow_len[fidx]               = pTcp->genTcpIpPkt(flow_tmpl, cfg, flow_frm_buf[fidx], payload_len);
+        }
+
+        for (uint32_t fidx = 0; fidx < NUM_FLOWS; fidx++)
+        {
+            const tcpIpPg::flow_t* flow  = pTcp->getFlow(IPV4_ADDR, FLOW_PORT_BASE + fidx, TCP_PORT);
+
+            flow_frames[fidx]            = flow->frames;
+            flow_bytes[fidx]             = flow->payload_bytes;
+        }
+
+        flow_rx_count                    = 0;
+        start                            = wallNs();
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            pTcp->TcpVpSendRawEthFrame(flow_frm_buf[it % NUM_FLOWS], flow_len[it % NUM_FLOWS]);
+        }
+        report("loopback_rx_flows", payload_len, frame_len, iterations, wallNs() - start);
+
+        if (flow_rx_count < iterations - 1)
+        {
+            fprintf(stderr, "***ERROR: only %d of %d looped back flow frames received\n", flow_rx_count, iterations);
+            error                        = 1;
+        }
+
+        // Each flow must have counted just the frames sent to it, bar the last one sent,
+        // which is still being received
+        for (uint32_t fidx = 0; fidx < NUM_FLOWS; fidx++)
+        {
+            const tcpIpPg::flow_t* flow  = pTcp->getFlow(IPV4_ADDR, FLOW_PORT_BASE + fidx, TCP_PORT);
+            uint64_t frames              = flow->frames - flow_frames[fidx];
+            uint64_t sent                = iterations / NUM_FLOWS + ((fidx < iterations % NUM_FLOWS) ? 1 : 0);
+            bool     last                = fidx == (iterations - 1) % NUM_FLOWS;
+
+            if ((frames != sent && !(last && frames == sent - 1)) || flow->payload_bytes - flow_bytes[fidx] != frames * payload_len)
+            {
+                fprintf(stderr, "***ERROR: flow %d counted %d frames of %d sent, with %d payload bytes\n", fidx,
+                        (int)frames, (int)sent, (int)(flow->payload_bytes - flow_bytes[fidx]));
+                error                    = 1;
+            }
+        }
+    }
+
+    // A runt frame (just the delimiters and preamble) after a good frame must be dropped as a
+    // bad CRC, and not processed with the good frame's headers still in the receive buffer
+    static const uint8_t runt[]          = {0xfb, 0x55, 0xd5, 0xfd};
+    uint32_t len                         = pTcp->genTcpIpPkt(cfg, frm_buf, payload, 0);
+    uint64_t bad_crc                     = pTcp->getStats().bad_crc;
+
+    rx_count                             = 0;
+    pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+    pTcp->TcpVpSendRawEthFrame(runt, sizeof(runt));
+    pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+    pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+
+    if (pTcp->getStats().bad_crc != bad_crc + 1 || rx_count < 2)
+    {
+        fprintf(stderr, "***ERROR: runt frame not dropped (%d bad CRC, %d good frames received)\n",
+                (int)(pTcp->getStats().bad_crc - bad_crc), rx_count);
+        error                            = 1;
+    }
+
+    // A bad IPv4 total length must be counted as an IPv4 header error, and not as a bad
+    // TCP checksum, with all the checks skipped (so the frame's CRC is left as generated)
+    tcpIpPg::chksumOffload_t offload     = pTcp->getChksumOffload();
+    tcpIpPg::chksumOffload_t skip_all    = offload;
+    tcpIpPg::rxStats_t       stats       = pTcp->getStats();
+
+    skip_all.rx_skip_checks              = tcpIpPg::RX_BAD_CRC | tcpIpPg::RX_BAD_IPV4_CHECKSUM | tcpIpPg::RX_BAD_TCP_CHECKSUM;
+    pTcp->setChksumOffload(skip_all);
+
+    len                                  = pTcp->genTcpIpPkt(cfg, frm_buf, payload, 0);
+    frm_buf[tcpIpPg::ETH_PREAMBLE + tcpIpPg::ETH_HDR_LEN + 2] = 0x0f;
+
+    pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+    pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+    pTcp->setChksumOffload(offload);
+
+    if (pTcp->getStats().bad_ipv4_chksum != stats.bad_ipv4_chksum + 2 || pTcp->getStats().bad_tcp_chksum != stats.bad_tcp_chksum)
+    {
+        fprintf(stderr, "***ERROR: bad IPv4 length not counted as an IPv4 header error (%d IPv4, %d TCP)\n",
+                (int)(pTcp->getStats().bad_ipv4_chksum - stats.bad_ipv4_chksum),
+                (int)(pTcp->getStats().bad_tcp_chksum - stats.bad_tcp_chksum));
+        error                            = 1;
+    }
+
+    delete pTcp;
+
+    return error;
+}
@@ -32,7 +32,7 @@
 tcpIpPg::rxInfo_t tcpConnect::initiateConnect(
     int                            node,
     tcpIpPg*                       &pTcp,
-    std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+    tcpIpPg::rxQueue_t             &rxQueue,
     uint32_t                       dst_port,
     uint32_t                       initial_winsize,
     uint32_t                       ip_dst_addr,
@@ -70,14 +70,14 @@ tcpIpPg::rxInfo_t tcpConnect::initiateConnect(
     // Wait for SYN-ACK
     while(rxQueue.empty())
     {
-        pTcp->TcpVpSendIdle(20);
+        pTcp->waitForRx();
     }
 
     // Get packet at the front of the receive queue
     tcpIpPg::rxInfo_t pkt = rxQueue.front();
 
     // Delete the packet
-    rxQueue.erase(rxQueue.begin());
+    rxQueue.pop();
 
     // Check Flags SYN ACK and payload 0
     if ((pkt.tcp_flags & (SYN | ACK)) == (SYN | ACK) && pkt.rx_len == 0)
@@ -106,12 +106,12 @@ tcpIpPg::rxInfo_t tcpConnect::initiateConnect(
         // Wait for ACK
         while(rxQueue.empty())
         {
-            pTcp->TcpVpSendIdle(20);
+            pTcp->waitForRx();
         }
 
         // Copy the received packet, and delete from the queue
         pkt = rxQueue.front();
-        rxQueue.erase(rxQueue.begin());
+        rxQueue.pop();
     }
 
     // Return received packet
@@ -127,7 +127,7 @@ tcpIpPg::rxInfo_t tcpConnect::initiateConnect(
 tcpIpPg::rxInfo_t tcpConnect::listenConnect(
     int                            node,
     tcpIpPg*                       &pTcp,
-    std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+    tcpIpPg::rxQueue_t             &rxQueue,
     uint32_t                       initial_winsize,
     uint32_t                       init_seq_num
 )
@@ -139,7 +139,7 @@ tcpIpPg::rxInfo_t tcpConnect::listenConnect(
     // Wait for wakeup
     while(rxQueue.empty())
     {
-        pTcp->TcpVpSendIdle(20);
+        pTcp->waitForRx();
     }
 
     // Get the packet at the front of the queue
@@ -170,18 +170,18 @@ tcpIpPg::rxInfo_t tcpConnect::listenConnect(
         pktCfg.seq_num      += 1;
 
         // Delete the processed RX packet
-        rxQueue.erase(rxQueue.begin());
+        rxQueue.pop();
 
         // Wait for ACK
         while(rxQueue.empty())
         {
-            pTcp->TcpVpSendIdle(20);
+            pTcp->waitForRx();
         }
 
         pkt = rxQueue.front();
 
         // Delete the processed RX packet
-        rxQueue.erase(rxQueue.begin());
+        rxQueue.pop();
 
         // Check we got an ack
         if (pkt.tcp_flags == ACK)
@@ -220,7 +220,7 @@ tcpIpPg::rxInfo_t tcpConnect::listenConnect(
     else
     {
         // Delete the unprocessed RX packet
-        rxQueue.erase(rxQueue.begin());
+        rxQueue.pop();
     }
 
     return pkt;
@@ -234,7 +234,7 @@ tcpIpPg::rxInfo_t tcpConnect::listenConnect(
 int tcpConnect::initiateTermination(
     int                            node,
     tcpIpPg*                       &pTcp,
-    std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+    tcpIpPg::rxQueue_t             &rxQueue,
     uint32_t                       dst_port,
     uint32_t                       winsize,
     uint32_t                       ip_dst_addr,
@@ -267,11 +267,11 @@ int tcpConnect::initiateTermination(
     // Wait for ACK
     while(rxQueue.empty())
     {
-        pTcp->TcpVpSendIdle(20);
+        pTcp->waitForRx();
     }
 
     tcpIpPg::rxInfo_t pkt = rxQueue.front();
-    rxQueue.erase(rxQueue.begin());
+    rxQueue.pop();
 
     if ((pkt.tcp_flags & ACK) && pkt.rx_len == 0)
     {
@@ -289,18 +289,18 @@ int tcpConnect::initiateTermination(
     else
     {
         // Expected an ACK (or ACK+FIN) packet
-        rxQueue.erase(rxQueue.begin());
+        rxQueue.pop();
         error = 2;
     }
 
     // Wait for FIN+ACK
     while(rxQueue.empty())
     {
-        pTcp->TcpVpSendIdle(20);
+        pTcp->waitForRx();
     }
 
     pkt = rxQueue.front();
-    rxQueue.erase(rxQueue.begin());
+    rxQueue.pop();
 
     if (pkt.tcp_flags & (ACK | FIN) != (ACK | FIN))
     {
@@ -321,7 +321,7 @@ int tcpConnect::initiateTermination(
  int tcpConnect::waitForTermination(
     int                            node,
     tcpIpPg*                       &pTcp,
-    std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+    tcpIpPg::rxQueue_t             &rxQueue,
     uint32_t                       winsize,
     uint32_t                       seq_num,
     uint32_t                       openPort,
@@ -344,11 +344,11 @@ int tcpConnect::initiateTermination(
             // Wait for Packet
             while(rxQueue.empty())
             {
-                pTcp->TcpVpSendIdle(20);
+                pTcp->waitForRx();
             }
 
             pkt = rxQueue.front();
-            rxQueue.erase(rxQueue.begin());
+            rxQueue.pop();
         }
 
         // Only process packets routed to the open port connections
@@ -384,11 +384,11 @@ int tcpConnect::initiateTermination(
                 // Wait for ACK
                 while(rxQueue.empty())
                 {
-                    pTcp->TcpVpSendIdle(20);
+                    pTcp->waitForRx();
                 }
 
                 tcpIpPg::rxInfo_t pkt = rxQueue.front();
-                rxQueue.erase(rxQueue.begin());
+                rxQueue.pop();
 
                 if (!((pkt.tcp_flags & ACK) && pkt.rx_len == 0))
                 {
@@ -45,7 +45,7 @@ public:
     // Method for initiating connection with a server
     tcpIpPg::rxInfo_t initiateConnect(int                            node,
                                       tcpIpPg*                       &pTcp,
-                                      std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+                                      tcpIpPg::rxQueue_t             &rxQueue,
                                       uint32_t                       dst_port,
                                       uint32_t                       initial_winsize,
                                       uint32_t                       ip_dst_addr,
@@ -55,7 +55,7 @@ public:
     // Method for a server to listen for connection request and process conection protocol
     tcpIpPg::rxInfo_t listenConnect  (int                            node,
                                       tcpIpPg*                       &pTcp,
-                                      std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+                                      tcpIpPg::rxQueue_t             &rxQueue,
                                       uint32_t                       initial_winsize,
                                       uint32_t                       init_seq_num = 0);
 
@@ -63,7 +63,7 @@ public:
     // Method to initiate termination of a connection and follow closure protocol
     int  initiateTermination         (int                            node,
                                       tcpIpPg*                       &pTcp,
-                                      std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+                                      tcpIpPg::rxQueue_t             &rxQueue,
                                       uint32_t                       dst_port,
                                       uint32_t                       winsize,
                                       uint32_t                       ip_dst_addr,
@@ -75,7 +75,7 @@ public:
     // Can process packets until termination initiated.
     int  waitForTermination          (int                            node,
                                       tcpIpPg*                       &pTcp,
-                                      std::vector<tcpIpPg::rxInfo_t> &rxQueue,
+                                      tcpIpPg::rxQueue_t             &rxQueue,
                                       uint32_t                       winsize,
                                       uint32_t                       seq_num,
                                       uint32_t                       openPort,
@@ -85,8 +85,8 @@ public:
 private:
 
     // Packet/data buffers
-    uint32_t frmBuf  [PKTBUFSIZE];
-    uint32_t payload [PKTBUFSIZE];
+    uint8_t  frmBuf  [PKTBUFSIZE];
+    uint8_t  payload [PKTBUFSIZE];
 
     // Packet configuration structure, for use with tcpIpPg class methods
     tcpIpPg::tcpConfig_t pktCfg;
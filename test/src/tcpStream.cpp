@@ -0,0 +1,135 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class method definitions of the streaming test programs
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <chrono>
+
+#include "tcpIpPg.h"
+#include "tcpStream.h"
+#include "tcpCommon.h"
+
+// --------------------------------------------
+// Send STREAM_FRAMES frames of STREAM_PAYLOAD
+// bytes to node 1, with sequence numbers
+// advancing by the payload length
+// --------------------------------------------
+
+uint32_t tcpStream0::runTest()
+{
+    static uint8_t frm_buf[PKTBUFSIZE];
+    static uint8_t payload[tcpIpPg::MAX_TCP_PAYLOAD];
+
+    pTcp = new tcpIpPg(node, CLIENT_IPV4_ADDR, CLIENT_MAC_ADDR, TCP_PORT_NUM);
+
+    // The mock's accesses are too quick for their timing to be worthwhile
+    pTcp->TcpVpSetPerfTiming(false);
+
+    if (STREAM_PAYLOAD > tcpIpPg::MAX_TCP_PAYLOAD)
+    {
+        VPrint("NODE%d: runTest() : ***ERROR. Stream payload (%d) too big. Must be <= %d\n",
+               node, STREAM_PAYLOAD, tcpIpPg::MAX_TCP_PAYLOAD);
+        return 1;
+    }
+
+    for (uint32_t idx = 0; idx < STREAM_PAYLOAD; idx++)
+    {
+        payload[idx]                     = idx;
+    }
+
+    tcpIpPg::tcpConfig_t cfg;
+
+    cfg.dst_port                         = TCP_PORT_NUM;
+    cfg.seq_num                          = 0;
+    cfg.ack_num                          = 0;
+    cfg.ack                              = true;
+    cfg.rst_conn                         = false;
+    cfg.sync_seq                         = false;
+    cfg.finish                           = false;
+    cfg.win_size                         = DEFAULTWINSIZE;
+    cfg.ip_dst_addr                      = SERVER_IPV4_ADDR;
+    cfg.mac_dst_addr                     = SERVER_MAC_ADDR;
+
+    for (uint32_t frame = 0; frame < STREAM_FRAMES; frame++)
+    {
+        uint32_t len                     = pTcp->genTcpIpPkt(cfg, frm_buf, payload, STREAM_PAYLOAD);
+
+        pTcp->TcpVpSendRawEthFrame(frm_buf, len);
+
+        cfg.seq_num                      += STREAM_PAYLOAD;
+    }
+
+    return 0;
+}
+
+// --------------------------------------------
+// Receive the stream from node 0, checking the
+// frames arrive in order, and report the rate
+// reached, in frames per second of run time
+// --------------------------------------------
+
+uint32_t tcpStream1::runTest()
+{
+    pTcp = new tcpIpPg(node, SERVER_IPV4_ADDR, SERVER_MAC_ADDR, TCP_PORT_NUM);
+
+    pTcp->TcpVpSetPerfTiming(false);
+    pTcp->registerUsrRxViewCbFunc(rxViewCallback, (void*)this);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t start_ticks                 = pTcp->TcpVpGetTicks();
+
+    // Receive until all the frames are in, or they stop arriving
+    while (rx_frames < STREAM_FRAMES && pTcp->waitForRx(STREAM_RX_TIMEOUT))
+        ;
+
+    double   secs                        = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint32_t ticks                       = pTcp->TcpVpGetTicks() - start_ticks;
+
+    VPrint("NODE%d: received %d of %d frames of %d payload bytes in %u ticks (%.2f ticks per frame)\n",
+           node, rx_frames, STREAM_FRAMES, STREAM_PAYLOAD, ticks, (double)ticks / (rx_frames ? rx_frames : 1));
+    VPrint("NODE%d: %.3f seconds, %.0f frames per second\n", node, secs, rx_frames / secs);
+
+    if (rx_frames != STREAM_FRAMES || rx_errors)
+    {
+        VPrint("NODE%d: runTest() : ***ERROR. %d frames missing, %d out of order\n",
+               node, STREAM_FRAMES - rx_frames, rx_errors);
+        return (STREAM_FRAMES - rx_frames) + rx_errors;
+    }
+
+    return 0;
+}
+
+// --------------------------------------------
+// Receive view callback
+// --------------------------------------------
+
+void tcpStream1::rxViewCallback (const tcpIpPg::rxHdr_t* rx_hdr, const tcpIpPg::rxView_t* rx_view, void* hdl)
+{
+    tcpStream1* pTest                    = (tcpStream1*)hdl;
+
+    if (rx_hdr->tcp_seq_num != pTest->next_seq || rx_view->payload_len != STREAM_PAYLOAD)
+    {
+        pTest->rx_errors++;
+    }
+
+    pTest->next_seq                      = rx_hdr->tcp_seq_num + rx_view->payload_len;
+    pTest->rx_frames++;
+}
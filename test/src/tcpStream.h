@@ -0,0 +1,80 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class definitions of the streaming test programs: node 0
+// sends a stream of TCP/IPv4 frames back to back, and node 1
+// receives and checks them, reporting the frame rate reached
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_STREAM_H_
+#define _TCP_STREAM_H_
+
+#include "tcpTestBase.h"
+
+// Number of frames streamed, and the TCP payload bytes of each
+#ifndef STREAM_FRAMES
+#define STREAM_FRAMES        100000
+#endif
+
+#ifndef STREAM_PAYLOAD
+#define STREAM_PAYLOAD       64
+#endif
+
+// Ticks without a frame after which the receiver gives up
+#define STREAM_RX_TIMEOUT    20000
+
+// --------------------------------------------
+// Sending node
+// --------------------------------------------
+
+class tcpStream0 : public tcpTestBase
+{
+public:
+    // Constructor
+    tcpStream0(int nodeIn) : tcpTestBase(nodeIn) {};
+
+    // Test method, sending the stream, returning the number of errors
+    uint32_t runTest     ();
+};
+
+// --------------------------------------------
+// Receiving node
+// --------------------------------------------
+
+class tcpStream1 : public tcpTestBase
+{
+public:
+    // Constructor
+    tcpStream1(int nodeIn) : tcpTestBase(nodeIn), rx_frames(0), rx_errors(0), next_seq(0) {};
+
+    // Test method, receiving the stream, returning the number of errors
+    uint32_t runTest     ();
+
+private:
+
+    // Receive view callback, counting the frames and checking they arrive in order
+    static void rxViewCallback (const tcpIpPg::rxHdr_t* rx_hdr, const tcpIpPg::rxView_t* rx_view, void* hdl);
+
+    uint32_t rx_frames;
+    uint32_t rx_errors;
+    uint32_t next_seq;
+};
+
+#endif
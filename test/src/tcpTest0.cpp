@@ -22,10 +22,15 @@
 //=============================================================
 
 #include <vector>
+#include <string.h>
 
 #include "tcpIpPg.h"
 #include "tcpTest0.h"
 #include "tcpCommon.h"
+#include "tcpTxEngine.h"
+
+// Number of lines of data sent with the transmit engine, each as a segment
+#define ENGINE_LINES 8
 
 // --------------------------------------------
 // --------------------------------------------
@@ -33,8 +38,9 @@
 uint32_t tcpTest0::runTest()
 {
     uint32_t payloadLen;
-    uint32_t payload [PKTBUFSIZE];
-    uint32_t frmBuf  [PKTBUFSIZE];
+    uint32_t errors = 0;
+    uint8_t  payload [PKTBUFSIZE];
+    uint8_t  frmBuf  [PKTBUFSIZE];
     char     vstr    [12];
     tcpIpPg::tcpConfig_t pktCfg;
 
@@ -45,6 +51,13 @@ uint32_t tcpTest0::runTest()
     
     VPrint("\ntcpIpPg version %s\n\n", vstr);
 
+    // Check the CRC engines against the bitwise reference
+    if (pTcp->crcSelfTest(true) != 0)
+    {
+        VPrint("***ERROR: CRC engine self-test failed at node %d\n", node);
+        errors++;
+    }
+
     // Let the simulation run for a few ticks
     pTcp->TcpVpSendIdle(SMALL_PAUSE);
 
@@ -72,7 +85,7 @@ uint32_t tcpTest0::runTest()
     char sbuf[STRBUFSIZE];
     payloadLen = sprintf(sbuf, "*** Data Packet from node %d ***\n\n", node);
 
-    // Copy string bytes to payload buffer (not bytes)
+    // Copy string bytes to payload buffer
     for (int idx = 0; idx < payloadLen; idx++)
     {
         payload[idx]    = sbuf[idx];
@@ -102,12 +115,12 @@ uint32_t tcpTest0::runTest()
     // Wait for an ACK
     while(rxQueue.empty())
     {
-        pTcp->TcpVpSendIdle(SMALL_PAUSE);
+        pTcp->waitForRx();
     }
 
     // Copy the received packet, and delete from the queue
     connLastPkt = rxQueue.front();
-    rxQueue.erase(rxQueue.begin());
+    rxQueue.pop();
 
     // Check that an ACK received, and all packets acknowledged, then initiate termination
     // of connection.
@@ -116,6 +129,34 @@ uint32_t tcpTest0::runTest()
 
         pTcp->TcpVpSendIdle(SMALL_PAUSE);
 
+        // Send a block of data with the sliding window transmit engine, with a line per
+        // segment, so that all the segments are in flight together
+        uint32_t lineLen  = 0;
+        uint32_t blockLen = 0;
+
+        for (int idx = 0; idx < ENGINE_LINES; idx++)
+        {
+            lineLen   = sprintf(sbuf, "*** Windowed data segment %d from node %d ***\n", idx, node);
+            memcpy(&payload[blockLen], sbuf, lineLen);
+            blockLen += lineLen;
+        }
+
+        tcpTxEngine txEngine(node, pTcp, rxQueue);
+
+        txEngine.open(pktCfg, connLastPkt.tcp_win_size, lineLen);
+
+        if (txEngine.send(payload, blockLen) != tcpTxEngine::TX_OK)
+        {
+            VPrint("***ERROR: transmit engine failed to send data at node %d\n", node);
+            errors++;
+        }
+
+        txEngine.printStats();
+
+        pktCfg.seq_num = txEngine.sndUna();
+
+        pTcp->TcpVpSendIdle(SMALL_PAUSE);
+
         VPrint("Node%d: initiating termination\n\n", node);
 
         int error = conn.initiateTermination(
@@ -131,11 +172,17 @@ uint32_t tcpTest0::runTest()
         if (error)
         {
             VPrint("***ERROR: bad status returned on termination (%d) at node %d\n", error, node);
+            errors++;
         }
 
     }
+    else
+    {
+        VPrint("***ERROR: data packet not acknowledged at node %d\n", node);
+        errors++;
+    }
 
     pTcp->TcpVpSendIdle(END_PAUSE);
 
-    return 0;
+    return errors;
 }
\ No newline at end of file
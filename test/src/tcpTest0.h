@@ -34,7 +34,7 @@ public:
     // Constructor
     tcpTest0(int nodeIn) : tcpTestBase(nodeIn) {};
 
-    // Test method, specific to this class
+    // Test method, specific to this class, returning the number of errors
     uint32_t runTest     ();
 };
 
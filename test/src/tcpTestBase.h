@@ -36,7 +36,7 @@ public:
     static const uint32_t SYN = 0x02;
     static const uint32_t FIN = 0x01;
 
-                     tcpTestBase(int nodeIn) : node(nodeIn), pTcp(NULL)
+                     tcpTestBase(int nodeIn) : node(nodeIn), pTcp(NULL), rxQueue(tcpIpPg::RX_QUEUE_SIZE)
                      {
                          init_seq = 0;
                          init_ack = 0;
@@ -47,7 +47,21 @@ public:
     
     // Simulation control methods
     void            sleepForever() {if (pTcp != NULL) while(true) pTcp->TcpVpSendIdle(20000000);};
-    void            haltSim     () {if (pTcp != NULL) pTcp->TcpVpSetHalt(1);};
+    void            haltSim     () {if (pTcp != NULL) {writePerf(); pTcp->TcpVpSetHalt(1);}};
+
+    // Write this node's performance counts to perf_node<n>.json
+    void            writePerf   ()
+    {
+        char fname[32];
+        snprintf(fname, sizeof(fname), "perf_node%d.json", node);
+
+        FILE* fp = fopen(fname, "w");
+        if (fp != NULL)
+        {
+            pTcp->writePerfJson(fp);
+            fclose(fp);
+        }
+    };
 
     // Callback function needs to be static to allow it to be used as an
     // argument in the callback registration function. It will be passed
@@ -64,8 +78,13 @@ public:
                                         ((tcpTestBase*)hdl)->init_ack
                                         );
         
-        // Append packet to the receive queue
-        ((tcpTestBase*)hdl)->rxQueue.push_back(rx_info);
+        // Append packet to the receive queue, which is bounded, so a full queue
+        // loses the packet
+        if (!((tcpTestBase*)hdl)->rxQueue.push(rx_info))
+        {
+            printf("NODE%d: rxCallback() : ***WARNING. receive queue full, dropping packet (%u dropped)\n",
+                   ((tcpTestBase*)hdl)->node, ((tcpTestBase*)hdl)->rxQueue.overflowCount());
+        }
     }
 
 protected:
@@ -76,7 +95,7 @@ protected:
     tcpIpPg*                       pTcp;
     
     // Receiver queue
-    std::vector<tcpIpPg::rxInfo_t> rxQueue;
+    tcpIpPg::rxQueue_t             rxQueue;
     
     // TCP connection state object.
     tcpConnect                     conn;
@@ -0,0 +1,242 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class method definitions for sliding window TCP transmit
+// engine
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <string.h>
+
+#include "tcpTxEngine.h"
+
+// --------------------------------------------
+// Method to start sending on an established
+// connection
+// --------------------------------------------
+
+void tcpTxEngine::open(const tcpIpPg::tcpConfig_t &cfg, uint32_t peerWin, uint32_t mssIn)
+{
+    uint32_t max_mss    = tcpIpPg::MAX_TCP_PAYLOAD;
+
+    pktCfg              = cfg;
+    pktCfg.ack          = true;
+    pktCfg.rst_conn     = false;
+    pktCfg.sync_seq     = false;
+    pktCfg.finish       = false;
+
+    pTcp->initFlowTemplate(tmpl, pktCfg);
+
+    snd_una             = cfg.seq_num;
+    snd_nxt             = cfg.seq_num;
+    snd_max             = cfg.seq_num;
+    peer_win            = peerWin;
+    mss                 = (mssIn == 0 || mssIn > max_mss) ? max_mss : mssIn;
+
+    rto                 = rto_init;
+    timer_running       = false;
+    retries             = 0;
+}
+
+// --------------------------------------------
+// Method to send a block of data, keeping up
+// to the peer's window of segments in flight
+// --------------------------------------------
+
+int tcpTxEngine::send(const uint8_t* data, uint32_t len)
+{
+    uint32_t base       = snd_una;
+    uint32_t end        = snd_una + len;
+    int      status     = TX_OK;
+
+    // Anything left in flight by an earlier call is sent again, from this data, so
+    // acknowledgements are only accepted for data this call has sent
+    snd_nxt             = snd_una;
+    snd_max             = snd_una;
+    snd_end             = end;
+    rto                 = rto_init;
+    timer_running       = false;
+    retries             = 0;
+
+    while (status == TX_OK && seqLt(snd_una, end))
+    {
+        // Send segments while the window has room. With a zero window, a single byte
+        // is sent after each timeout, to probe for the window opening.
+        uint32_t wnd    = (peer_win == 0 && retries) ? 1 : peer_win;
+
+        while (status == TX_OK && seqLt(snd_nxt, end) && seqLt(snd_nxt, snd_una + wnd))
+        {
+            uint32_t seg_len = end - snd_nxt;
+
+            seg_len     = (seg_len > mss) ? mss : seg_len;
+            seg_len     = (seg_len > snd_una + wnd - snd_nxt) ? snd_una + wnd - snd_nxt : seg_len;
+
+            sendSegment(&data[snd_nxt - base], seg_len, snd_nxt);
+
+            snd_nxt    += seg_len;
+
+            // Keep the receive queue drained of acknowledgements whilst sending
+            status      = processAcks();
+            wnd         = (peer_win == 0 && retries) ? 1 : peer_win;
+        }
+
+        if (status != TX_OK || !seqLt(snd_una, end))
+        {
+            break;
+        }
+
+        // With a zero window and nothing in flight, time the wait to probe it
+        if (!timer_running)
+        {
+            rto_deadline  = pTcp->TcpVpGetTicks() + rto;
+            timer_running = true;
+        }
+
+        // Wait for acknowledgements, up to the retransmission timeout
+        uint32_t now    = pTcp->TcpVpGetTicks();
+
+        if (rxQueue.empty() && (int32_t)(rto_deadline - now) > 0)
+        {
+            pTcp->waitForRx(rto_deadline - now);
+        }
+
+        status          = processAcks();
+
+        // On a timeout, go back to the first unacknowledged byte, with the timeout doubled
+        if (status == TX_OK && seqLt(snd_una, end) && timer_running && (int32_t)(pTcp->TcpVpGetTicks() - rto_deadline) >= 0)
+        {
+            if (retries == max_retries)
+            {
+                VPrint("Node%d: tcpTxEngine::send() : ***ERROR. No acknowledgement after %d retries (seq 0x%08x)\n",
+                       node, retries, snd_una);
+                status  = TX_ERR_TIMEOUT;
+            }
+            else
+            {
+                retries++;
+                timeouts++;
+
+                rto           = (rto > MAX_RTO/2) ? MAX_RTO : rto * 2;
+                snd_nxt       = snd_una;
+                timer_running = false;
+            }
+        }
+    }
+
+    return status;
+}
+
+// --------------------------------------------
+// Method to display the transmit counts
+// --------------------------------------------
+
+void tcpTxEngine::printStats(void)
+{
+    VPrint("Node%d: TX engine: %d segments sent, %d resent, %d timeouts\n", node, segs_sent, segs_resent, timeouts);
+}
+
+// --------------------------------------------
+// Method to generate and send a segment, from
+// the connection's header template, starting
+// the retransmission timer if not running
+// --------------------------------------------
+
+void tcpTxEngine::sendSegment(const uint8_t* payload, uint32_t len, uint32_t seq)
+{
+    memcpy(pTcp->getPayloadPtr(frmBuf), payload, len);
+
+    pktCfg.seq_num      = seq;
+
+    uint32_t frm_len    = pTcp->genTcpIpPkt(tmpl, pktCfg, frmBuf, len);
+
+    pTcp->TcpVpShapeFrame(shaper, frm_len);
+    pTcp->TcpVpSendRawEthFrame(frmBuf, frm_len);
+
+    segs_sent++;
+    segs_resent        += seqLt(seq, snd_max) ? 1 : 0;
+    snd_max             = seqLt(snd_max, seq + len) ? seq + len : snd_max;
+
+    if (!timer_running)
+    {
+        rto_deadline    = pTcp->TcpVpGetTicks() + rto;
+        timer_running   = true;
+    }
+}
+
+// --------------------------------------------
+// Method to process the acknowledgements at
+// the front of the receive queue, stopping at
+// any other packet
+// --------------------------------------------
+
+int tcpTxEngine::processAcks(void)
+{
+    while (!rxQueue.empty())
+    {
+        tcpIpPg::rxInfo_t &pkt = rxQueue.front();
+
+        if (pkt.tcp_src_port != pktCfg.dst_port)
+        {
+            return TX_ERR_UNEXPECTED;
+        }
+
+        if (pkt.tcp_flags & RST)
+        {
+            return TX_ERR_RESET;
+        }
+
+        if (!(pkt.tcp_flags & ACK) || (pkt.tcp_flags & (SYN | FIN)) || pkt.rx_len)
+        {
+            return TX_ERR_UNEXPECTED;
+        }
+
+        uint32_t ack    = pkt.tcp_ack_num;
+
+        // A cumulative acknowledgement of new data, sent and within the block being
+        // sent, advances the window and restarts the timer (or stops it if nothing is
+        // left in flight)
+        if (seqLt(snd_una, ack) && seqLe(ack, snd_max) && seqLe(ack, snd_end))
+        {
+            snd_una     = ack;
+            snd_nxt     = seqLt(snd_nxt, ack) ? ack : snd_nxt;
+            rto         = rto_init;
+            retries     = 0;
+
+            if (snd_una == snd_max)
+            {
+                timer_running = false;
+            }
+            else
+            {
+                rto_deadline  = pTcp->TcpVpGetTicks() + rto;
+                timer_running = true;
+            }
+        }
+
+        // The window is as advertised by the latest acknowledgement, ignoring older ones
+        if (ack == snd_una)
+        {
+            peer_win    = pkt.tcp_win_size;
+        }
+
+        rxQueue.pop();
+    }
+
+    return TX_OK;
+}
@@ -0,0 +1,151 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Class definition of a sliding window TCP transmit engine,
+// sending data on an established connection with up to the
+// peer's advertised window of segments in flight
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _TCP_TX_ENGINE_H_
+#define _TCP_TX_ENGINE_H_
+
+#include <cstdint>
+
+#include "tcpCommon.h"
+#include "tcpIpPg.h"
+
+class tcpTxEngine
+{
+public:
+
+    // Bit masks of TCP flags field
+    static const uint32_t ACK                  = 0x10;
+    static const uint32_t RST                  = 0x04;
+    static const uint32_t SYN                  = 0x02;
+    static const uint32_t FIN                  = 0x01;
+
+    // Default maximum segment size, and retransmission timeout (100us at 156.25MHz),
+    // which doubles on each expiry up to the maximum, and the number of consecutive
+    // expiries before giving up
+    static const uint32_t DEFAULT_MSS          = 1460;  // BYTES
+    static const uint32_t DEFAULT_RTO          = 15625; // TICKS
+    static const uint32_t MAX_RTO              = 64 * DEFAULT_RTO;
+    static const uint32_t DEFAULT_MAX_RETRIES  = 8;
+
+    // Status returned by send()
+    static const int      TX_OK                = 0;
+    static const int      TX_ERR_TIMEOUT       = 1;
+    static const int      TX_ERR_RESET         = 2;
+    static const int      TX_ERR_UNEXPECTED    = 3;
+
+    // Constructor
+    tcpTxEngine(int nodeIn, tcpIpPg* pTcpIn, tcpIpPg::rxQueue_t &rxQueueIn) :
+                    node(nodeIn), pTcp(pTcpIn), rxQueue(rxQueueIn), shaper(tcpIpPg::CLK10G_FREQ)
+    {
+        mss             = DEFAULT_MSS;
+        rto_init        = DEFAULT_RTO;
+        max_retries     = DEFAULT_MAX_RETRIES;
+        snd_una         = 0;
+        snd_nxt         = 0;
+        snd_max         = 0;
+        snd_end         = 0;
+        peer_win        = 0;
+        resetStats();
+    };
+
+    // Method to start sending on an established connection. The dst_port, ip_dst_addr,
+    // mac_dst_addr, ack_num and win_size fields of cfg are used for the segments sent,
+    // starting from seq_num. peerWin is the window last advertised by the peer.
+    void     open        (const tcpIpPg::tcpConfig_t &cfg, uint32_t peerWin, uint32_t mssIn = DEFAULT_MSS);
+
+    // Method to send len bytes of data from the first unacknowledged byte, keeping up to
+    // the peer's window in flight, until all are acknowledged. Segments are retransmitted,
+    // from the first unacknowledged byte, when the retransmission timeout expires. Returns
+    // early, leaving the packet at the front of rxQueue, if one arrives that isn't an
+    // acknowledgement (sndUna() then gives how far the data was acknowledged).
+    int      send        (const uint8_t* data, uint32_t len);
+
+    // Set the initial retransmission timeout and number of retries
+    void     setRto      (uint32_t ticks)   {rto_init = ticks;};
+    void     setRetries  (uint32_t retries) {max_retries = retries;};
+
+    // Set the connection's rate in bits per second (0 for unshaped) and burst size in
+    // bytes, in addition to any rate set for the node
+    void     setRate     (uint64_t rate_bps, uint32_t burst_bytes) {shaper.setRate(rate_bps, burst_bytes);};
+
+    // Send sequence state and the peer's advertised window
+    uint32_t sndUna      (void) {return snd_una;};
+    uint32_t sndNxt      (void) {return snd_nxt;};
+    uint32_t peerWindow  (void) {return peer_win;};
+
+    // Methods to clear and display the transmit counts
+    void     resetStats  (void) {segs_sent = 0; segs_resent = 0; timeouts = 0;};
+    void     printStats  (void);
+
+private:
+
+    // Sequence number comparisons, modulo 2^32
+    static bool seqLt    (uint32_t a, uint32_t b) {return (int32_t)(a - b) < 0;};
+    static bool seqLe    (uint32_t a, uint32_t b) {return (int32_t)(a - b) <= 0;};
+
+    // Method to send a segment of len bytes of payload, with sequence number seq
+    void     sendSegment (const uint8_t* payload, uint32_t len, uint32_t seq);
+
+    // Method to process any acknowledgements on the receive queue
+    int      processAcks (void);
+
+    // Node, packet generator and receive queue for the connection
+    int                            node;
+    tcpIpPg*                       pTcp;
+    tcpIpPg::rxQueue_t             &rxQueue;
+
+    // Send sequence state: first unacknowledged, next to send, highest sent and the end
+    // of the block being sent
+    uint32_t                       snd_una;
+    uint32_t                       snd_nxt;
+    uint32_t                       snd_max;
+    uint32_t                       snd_end;
+    uint32_t                       peer_win;
+    uint32_t                       mss;
+
+    // Retransmission timer: initial and current timeout, expiry tick, and expiries
+    // since the last new acknowledgement
+    uint32_t                       rto_init;
+    uint32_t                       rto;
+    uint32_t                       rto_deadline;
+    bool                           timer_running;
+    uint32_t                       retries;
+    uint32_t                       max_retries;
+
+    // Transmit counts
+    uint32_t                       segs_sent;
+    uint32_t                       segs_resent;
+    uint32_t                       timeouts;
+
+    // Connection's rate shaper
+    tcpShaper                      shaper;
+
+    // Frame buffer, and the connection's packet configuration and header template
+    uint8_t                        frmBuf [PKTBUFSIZE];
+    tcpIpPg::tcpConfig_t           pktCfg;
+    tcpIpPg::tcpFlowTemplate_t     tmpl;
+};
+
+#endif
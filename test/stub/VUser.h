@@ -0,0 +1,94 @@
+//=============================================================
+//
+// Copyright (c) 2026 Simon Southwell. All rights reserved.
+//
+// Date: 17th October 2026
+//
+// Stub VProc user API, for building the tcpIpPg code without a
+// simulator (e.g. for benchmarking). The tcp_ip_pg TXD/TXC
+// registers are looped back, so that words sent are received
+// by the same node, and the tick counter advances on each
+// clocked access. All other registers read as zero.
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _VUSER_H_
+#define _VUSER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// tcp_ip_pg register addresses modelled
+#define VUSER_STUB_TXC_ADDR    2
+#define VUSER_STUB_TICKS_ADDR  3
+
+#define VPrint printf
+
+typedef int (*pVUserInt_t)(void);
+
+// Looped back TXD/TXC registers, and tick counter
+static uint32_t vuser_stub_regs[VUSER_STUB_TXC_ADDR+1] = {0x07070707, 0x07070707, 0xff};
+static uint32_t vuser_stub_ticks                       = 0;
+
+static inline int VWrite(unsigned addr, unsigned data, int delta, uint32_t node)
+{
+    if (addr <= VUSER_STUB_TXC_ADDR)
+    {
+        vuser_stub_regs[addr] = data;
+    }
+
+    vuser_stub_ticks += delta ? 0 : 1;
+
+    return 0;
+}
+
+static inline int VRead(unsigned addr, unsigned *data, int delta, uint32_t node)
+{
+    *data = (addr <= VUSER_STUB_TXC_ADDR)    ? vuser_stub_regs[addr] :
+            (addr == VUSER_STUB_TICKS_ADDR) ? vuser_stub_ticks      : 0;
+
+    vuser_stub_ticks += delta ? 0 : 1;
+
+    return 0;
+}
+
+static inline int VBurstWrite(unsigned addr, void* data, unsigned length, uint32_t node)
+{
+    return 0;
+}
+
+static inline int VBurstRead(unsigned addr, void* data, unsigned length, uint32_t node)
+{
+    for (unsigned idx = 0; idx < length; idx++)
+    {
+        ((uint32_t*)data)[idx] = 0;
+    }
+
+    return 0;
+}
+
+static inline int VTick(unsigned ticks, uint32_t node)
+{
+    vuser_stub_ticks += ticks;
+
+    return 0;
+}
+
+static inline void VRegInterrupt(int level, pVUserInt_t func, uint32_t node)
+{
+}
+
+#endif
@@ -35,6 +35,22 @@
 `define TXC_ADDR                      32'h2
 `define TICKS_ADDR                    32'h3
 `define HLT_ADDR                      32'h4
+`define TXSEND_ADDR                   32'h5
+`define RXCOUNT_ADDR                  32'h6
+`define TXSPACE_ADDR                  32'h7
+`define IRQEN_ADDR                    32'h8
+`define IDLE_ADDR                     32'h9
+
+// Burst buffer regions, where every access anywhere in the
+// region is to the next word of the buffer, so a burst may
+// increment the address within the region
+`define TXBUF_ADDR                    32'h10000
+`define RXBUF_ADDR                    32'h20000
+`define BUF_ADDR_MASK                 32'hffff0000
+
+`define IDLE_WORD                     64'h0707070707070707
+`define SOF_CHAR                      8'hfb
+`define EOF_CHAR                      8'hfd
 
 // ============================================
 //  MODULE
@@ -45,8 +61,8 @@ module tcp_ip_pg
 (
   input                                clk,
 
-  output reg [63:0]                    txd,
-  output reg  [7:0]                    txc,
+  output     [63:0]                    txd,
+  output      [7:0]                    txc,
 
   input      [63:0]                    rxd,
   input       [7:0]                    rxc,
@@ -54,12 +70,87 @@ module tcp_ip_pg
   output reg                           halt
 );
 
+// --------------------------------------------
+// Local parameters
+// --------------------------------------------
+
+// TX FIFO and RX capture buffer depths (in 64 bit XGMII words)
+localparam  TXBUF_ADDR_BITS            = 11;
+localparam  TXBUF_DEPTH                = 1 << TXBUF_ADDR_BITS;
+localparam  RXBUF_ADDR_BITS            = 10;
+localparam  RXBUF_DEPTH                = 1 << RXBUF_ADDR_BITS;
+
 // --------------------------------------------
 // Signal definitions
 // --------------------------------------------
 
 integer     count;
 
+// TX words written directly by VProc
+reg  [63:0] txd_vp;
+reg   [7:0] txc_vp;
+
+// TX FIFO, with {TXC, TXD} entries, and write state. Words between
+// the commit and write pointers are not yet available to send.
+reg  [71:0] txmem [0:TXBUF_DEPTH-1];
+reg  [63:0] tx_wr_stage;
+reg   [1:0] tx_wr_word;
+reg  [TXBUF_ADDR_BITS-1:0] tx_wr_ptr;
+reg  [TXBUF_ADDR_BITS-1:0] tx_commit_ptr;
+
+// TX FIFO playback state
+reg  [TXBUF_ADDR_BITS-1:0] tx_rd_ptr;
+reg         tx_play_en;
+reg  [63:0] txd_play;
+reg   [7:0] txc_play;
+wire [TXBUF_ADDR_BITS-1:0] tx_fill;
+wire [TXBUF_ADDR_BITS-1:0] tx_space;
+
+// RX frame buffer, with {RXC, RXD} entries, and state. Words between
+// the frame and write pointers are of a frame still being received.
+reg  [71:0] rxmem [0:RXBUF_DEPTH-1];
+reg  [RXBUF_ADDR_BITS-1:0] rx_cap_wptr;
+reg  [RXBUF_ADDR_BITS-1:0] rx_frm_wptr;
+reg  [RXBUF_ADDR_BITS-1:0] rx_cap_rptr;
+reg   [1:0] rx_rd_word;
+reg         rx_in_frame;
+reg         rx_dropping;
+reg  [15:0] rx_ovfl_count;
+reg  [15:0] rx_frm_count;
+wire        rx_idle;
+wire        rx_sof;
+wire        rx_eof;
+wire [RXBUF_ADDR_BITS-1:0] rx_cap_count;
+
+// Interrupt enable, and RX frame interrupt
+reg         rx_irq_en;
+wire        rx_irq;
+
+// Idle wait deadline tick, RX frame count at the start of the wait, and
+// read acknowledge held off whilst waiting
+reg  [31:0] idle_deadline;
+reg  [15:0] idle_frm_count;
+wire        idle_wait;
+wire        rd_ack;
+
+// --------------------------------------------
+// Function to detect a given control character
+// on any lane of an XGMII word
+// --------------------------------------------
+
+function has_ctrl_char;
+  input [63:0] d;
+  input  [7:0] c;
+  input  [7:0] char;
+  integer      idx;
+begin
+  has_ctrl_char                        = 1'b0;
+  for (idx = 0; idx < 8; idx = idx + 1)
+    if (c[idx] && d[idx*8 +: 8] == char)
+      has_ctrl_char                    = 1'b1;
+end
+endfunction
+
 wire [31:0] nodenum = NODE;
 wire [63:0] rxd_int;
 wire  [7:0] rxc_int;
@@ -81,6 +172,32 @@ reg         UpdateResponse;
 assign #1   rxd_int                    = rxd;
 assign #1   rxc_int                    = rxc;
 
+// TX output from the FIFO when playing, else as written by VProc
+assign      txd                        = tx_play_en ? txd_play : txd_vp;
+assign      txc                        = tx_play_en ? txc_play : txc_vp;
+
+// Committed words waiting to be sent, and free FIFO space (one entry is
+// always left empty to distinguish full from empty)
+assign      tx_fill                    = tx_commit_ptr - tx_rd_ptr;
+assign      tx_space                   = tx_rd_ptr - tx_wr_ptr - 1'b1;
+
+assign      rx_idle                    = (rxd_int == `IDLE_WORD && rxc_int == 8'hff);
+assign      rx_sof                     = has_ctrl_char(rxd_int, rxc_int, `SOF_CHAR);
+assign      rx_eof                     = has_ctrl_char(rxd_int, rxc_int, `EOF_CHAR);
+
+// Words of completely received frames available to read
+assign      rx_cap_count               = rx_frm_wptr - rx_cap_rptr;
+
+// Interrupt whilst completed frames are in the RX buffer
+assign      rx_irq                     = rx_irq_en & (rx_cap_count != 0);
+
+// A read of the idle register waits until the deadline tick is reached, or
+// until a completed frame is in the RX buffer or has arrived since the wait
+// was set (in case an interrupt has already read it)
+assign      idle_wait                  = (Addr == `IDLE_ADDR) && ($signed(idle_deadline - count) > 0) &&
+                                         (rx_cap_count == 0) && (rx_frm_count == idle_frm_count);
+assign      rd_ack                     = RD & ~idle_wait;
+
 // --------------------------------------------
 // Initialisation
 // --------------------------------------------
@@ -88,8 +205,28 @@ assign #1   rxc_int                    = rxc;
 initial
 begin
   UpdateResponse                       = 1'b1;
-  txd                                  = 64'h0707070707070707;
-  txc                                  = 8'hff;
+  txd_vp                               = `IDLE_WORD;
+  txc_vp                               = 8'hff;
+
+  tx_wr_word                           = 2'd0;
+  tx_wr_ptr                            = 0;
+  tx_commit_ptr                        = 0;
+  tx_rd_ptr                            = 0;
+  tx_play_en                           = 1'b0;
+  txd_play                             = `IDLE_WORD;
+  txc_play                             = 8'hff;
+
+  rx_cap_wptr                          = 0;
+  rx_frm_wptr                          = 0;
+  rx_cap_rptr                          = 0;
+  rx_rd_word                           = 2'd0;
+  rx_in_frame                          = 1'b0;
+  rx_dropping                          = 1'b0;
+  rx_ovfl_count                        = 16'd0;
+  rx_frm_count                         = 16'd0;
+  rx_irq_en                            = 1'b0;
+  idle_deadline                        = 32'h0;
+  idle_frm_count                       = 16'd0;
 
   count                                = 0;
   halt                                 = 1'b0;
@@ -104,6 +241,73 @@ begin
   count                                <= count + 1;
 end
 
+// --------------------------------------------
+// Process to play out committed words from the
+// TX FIFO, one per clock. When the FIFO is empty
+// the output reverts to idle.
+// --------------------------------------------
+
+always @(posedge clk)
+begin
+  tx_play_en                           <= 1'b0;
+
+  if (tx_fill != 0)
+  begin
+    {txc_play, txd_play}               <= txmem[tx_rd_ptr];
+    tx_play_en                         <= 1'b1;
+    tx_rd_ptr                          <= tx_rd_ptr + 1'b1;
+  end
+end
+
+// --------------------------------------------
+// Process to capture RX frames for burst reads.
+// Words from one containing a start-of-frame
+// to one containing an end-of-frame (or an idle
+// word, if the frame is truncated) are stored,
+// and made available once the frame completes.
+// A frame that doesn't fit is dropped and
+// counted.
+// --------------------------------------------
+
+always @(posedge clk)
+begin
+  if (rx_in_frame || rx_sof)
+  begin
+    // Store the word, unless the buffer is full or the frame is being dropped
+    if (!rx_dropping)
+    begin
+      if ((rx_cap_wptr + 1'b1) != rx_cap_rptr)
+      begin
+        rxmem[rx_cap_wptr]             <= {rxc_int, rxd_int};
+        rx_cap_wptr                    <= rx_cap_wptr + 1'b1;
+      end
+      else
+      begin
+        rx_cap_wptr                    <= rx_frm_wptr;
+        rx_dropping                    <= 1'b1;
+        rx_ovfl_count                  <= rx_ovfl_count + 16'd1;
+      end
+    end
+
+    // At the end of the frame, make the stored words available
+    if (rx_in_frame && (rx_eof || rx_idle))
+    begin
+      rx_in_frame                      <= 1'b0;
+      rx_dropping                      <= 1'b0;
+
+      if (!rx_dropping && (rx_cap_wptr + 1'b1) != rx_cap_rptr)
+      begin
+        rx_frm_wptr                    <= rx_cap_wptr + 1'b1;
+        rx_frm_count                   <= rx_frm_count + 16'd1;
+      end
+    end
+    else
+    begin
+      rx_in_frame                      <= 1'b1;
+    end
+  end
+end
+
 // --------------------------------------------
 // Asynchronous process to access the ports and
 // internal state.
@@ -116,6 +320,46 @@ begin
 
   if (WE == 1'b1 || RD == 1'b1)
   begin
+    // Writes to the TX buffer region are the next TXD low, TXD high and TXC
+    // words of the next FIFO entry
+    if ((Addr & `BUF_ADDR_MASK) == `TXBUF_ADDR)
+    begin
+      if (WE == 1'b1)
+      begin
+        case (tx_wr_word)
+        2'd0: tx_wr_stage[31:0]        = DataOut;
+        2'd1: tx_wr_stage[63:32]       = DataOut;
+        default: begin
+          txmem[tx_wr_ptr]             = {DataOut[7:0], tx_wr_stage};
+          tx_wr_ptr                    = tx_wr_ptr + 1'b1;
+        end
+        endcase
+
+        tx_wr_word                     = (tx_wr_word == 2'd2) ? 2'd0 : tx_wr_word + 2'd1;
+      end
+    end
+    // Reads from the RX buffer region return the next RXD low, RXD high and RXC
+    // words of the oldest captured entry
+    else if ((Addr & `BUF_ADDR_MASK) == `RXBUF_ADDR)
+    begin
+      case (rx_rd_word)
+      2'd0:    DataIn                  = rxmem[rx_cap_rptr][31:0];
+      2'd1:    DataIn                  = rxmem[rx_cap_rptr][63:32];
+      default: DataIn                  = {24'h0, rxmem[rx_cap_rptr][71:64]};
+      endcase
+
+      if (RD == 1'b1)
+      begin
+        if (rx_rd_word == 2'd2)
+        begin
+          rx_cap_rptr                  = rx_cap_rptr + 1'b1;
+        end
+
+        rx_rd_word                     = (rx_rd_word == 2'd2) ? 2'd0 : rx_rd_word + 2'd1;
+      end
+    end
+    else
+    begin
     case (Addr)
 
     // Update the TXD low word, if a write, and read the low RXD inputs
@@ -123,7 +367,7 @@ begin
       DataIn                           = rxd_int[31:0];
       if (WE == 1'b1)
       begin
-        txd[31:0]                      = DataOut;
+        txd_vp[31:0]                   = DataOut;
       end
     end
 
@@ -132,7 +376,7 @@ begin
       DataIn                           = rxd_int[63:32];
       if (WE == 1'b1)
       begin
-        txd[63:32]                     = DataOut;
+        txd_vp[63:32]                  = DataOut;
       end
     end
 
@@ -141,7 +385,7 @@ begin
       DataIn                           = {24'h0, rxc_int};
       if (WE == 1'b1)
       begin
-        txc                            = DataOut[7:0];
+        txc_vp                         = DataOut[7:0];
       end
     end
 
@@ -162,12 +406,63 @@ begin
       end
     end
 
+    // A write commits the specified number of written words to the TX FIFO
+    // to be sent, discarding any other uncommitted words. A read returns the
+    // number of committed words still to be sent.
+    `TXSEND_ADDR: begin
+      DataIn                           = {{(32-TXBUF_ADDR_BITS){1'b0}}, tx_fill};
+      if (WE == 1'b1)
+      begin
+        tx_commit_ptr                  = tx_commit_ptr + DataOut[TXBUF_ADDR_BITS-1:0];
+        tx_wr_ptr                      = tx_commit_ptr;
+        tx_wr_word                     = 2'd0;
+      end
+    end
+
+    // A read returns the number of free words in the TX FIFO
+    `TXSPACE_ADDR: begin
+      DataIn                           = {{(32-TXBUF_ADDR_BITS){1'b0}}, tx_space};
+    end
+
+    // A read returns the RX buffer dropped frame count and number of words of
+    // completed frames. A write discards all completed frames.
+    `RXCOUNT_ADDR: begin
+      DataIn                           = {rx_ovfl_count, {(16-RXBUF_ADDR_BITS){1'b0}}, rx_cap_count};
+      if (WE == 1'b1)
+      begin
+        rx_cap_rptr                    = rx_frm_wptr;
+        rx_rd_word                     = 2'd0;
+      end
+    end
+
+    // A write sets the idle deadline to the given number of ticks from now.
+    // A read is not acknowledged until the deadline, or until a frame has
+    // been received, and returns the ticks remaining.
+    `IDLE_ADDR: begin
+      DataIn                           = idle_deadline - count;
+      if (WE == 1'b1)
+      begin
+        idle_deadline                  = count + DataOut;
+        idle_frm_count                 = rx_frm_count;
+      end
+    end
+
+    // Bit 0 enables the interrupt for completed RX frames
+    `IRQEN_ADDR: begin
+      DataIn                           = {31'h0, rx_irq_en};
+      if (WE == 1'b1)
+      begin
+        rx_irq_en                      = DataOut[0];
+      end
+    end
+
     // Only the above addresses are valid.
     default: begin
        $display("***ERROR: tcp_ip_pg---access to invalid address from VProc");
        $finish;
     end
     endcase
+    end
   end
 
   // Acknowledge the access by inverting the response input to VProc
@@ -187,8 +482,8 @@ end
    .DataOut                            (DataOut),
    .DataIn                             (DataIn),
    .WRAck                              (WE),
-   .RDAck                              (RD),
-   .Interrupt                          (3'b000),
+   .RDAck                              (rd_ack),
+   .Interrupt                          ({2'b00, rx_irq}),
    .Update                             (Update),
    .UpdateResponse                     (UpdateResponse),
    .Node                               (nodenum[3:0])
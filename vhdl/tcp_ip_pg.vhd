@@ -52,6 +52,45 @@ architecture behavioural of tcp_ip_pg is
   constant TXC_ADDR                    : std_logic_vector(31 downto 0) := 32x"2";
   constant TICKS_ADDR                  : std_logic_vector(31 downto 0) := 32x"3";
   constant HLT_ADDR                    : std_logic_vector(31 downto 0) := 32x"4";
+  constant TXSEND_ADDR                 : std_logic_vector(31 downto 0) := 32x"5";
+  constant RXCOUNT_ADDR                : std_logic_vector(31 downto 0) := 32x"6";
+  constant TXSPACE_ADDR                : std_logic_vector(31 downto 0) := 32x"7";
+  constant IRQEN_ADDR                  : std_logic_vector(31 downto 0) := 32x"8";
+  constant IDLE_ADDR                   : std_logic_vector(31 downto 0) := 32x"9";
+
+  -- Burst buffer regions, where every access anywhere in the
+  -- region is to the next word of the buffer, so a burst may
+  -- increment the address within the region
+  constant TXBUF_ADDR                  : std_logic_vector(31 downto 0) := 32x"10000";
+  constant RXBUF_ADDR                  : std_logic_vector(31 downto 0) := 32x"20000";
+  constant BUF_ADDR_MASK               : std_logic_vector(31 downto 0) := 32x"FFFF0000";
+
+  constant IDLE_WORD                   : std_logic_vector(63 downto 0) := 64x"0707070707070707";
+  constant SOF_CHAR                    : std_logic_vector( 7 downto 0) := 8x"FB";
+  constant EOF_CHAR                    : std_logic_vector( 7 downto 0) := 8x"FD";
+
+  -- TX FIFO and RX capture buffer depths (in 64 bit XGMII words)
+  constant TXBUF_ADDR_BITS             : integer := 11;
+  constant TXBUF_DEPTH                 : integer := 2**TXBUF_ADDR_BITS;
+  constant RXBUF_ADDR_BITS             : integer := 10;
+  constant RXBUF_DEPTH                 : integer := 2**RXBUF_ADDR_BITS;
+
+  -- Buffer entries are {TXC/RXC, TXD/RXD}
+  type tx_mem_t is array (0 to TXBUF_DEPTH-1) of std_logic_vector(71 downto 0);
+  type rx_mem_t is array (0 to RXBUF_DEPTH-1) of std_logic_vector(71 downto 0);
+
+  -- Function to detect a given control character on any lane of an XGMII word
+  function has_ctrl_char (d : std_logic_vector(63 downto 0);
+                          c : std_logic_vector( 7 downto 0);
+                          char : std_logic_vector(7 downto 0)) return std_logic is
+  begin
+    for idx in 0 to 7 loop
+      if c(idx) = '1' and d(idx*8+7 downto idx*8) = char then
+        return '1';
+      end if;
+    end loop;
+    return '0';
+  end function;
 
   -- Signals for VProc
   signal update                        : std_logic;
@@ -67,6 +106,53 @@ architecture behavioural of tcp_ip_pg is
 
   signal ClkCount                      : integer := 0;
 
+  -- TX words written directly by VProc
+  signal txd_vp                        : std_logic_vector(63 downto 0) := IDLE_WORD;
+  signal txc_vp                        : std_logic_vector( 7 downto 0) := 8x"FF";
+
+  -- TX FIFO and write state. Words between the commit and write
+  -- pointers are not yet available to send.
+  signal txmem                         : tx_mem_t;
+  signal tx_wr_stage                   : std_logic_vector(63 downto 0) := (others => '0');
+  signal tx_wr_word                    : integer range 0 to 2 := 0;
+  signal tx_wr_ptr                     : unsigned(TXBUF_ADDR_BITS-1 downto 0) := (others => '0');
+  signal tx_commit_ptr                 : unsigned(TXBUF_ADDR_BITS-1 downto 0) := (others => '0');
+
+  -- TX FIFO playback state
+  signal tx_rd_ptr                     : unsigned(TXBUF_ADDR_BITS-1 downto 0) := (others => '0');
+  signal tx_play_en                    : std_logic := '0';
+  signal txd_play                      : std_logic_vector(63 downto 0) := IDLE_WORD;
+  signal txc_play                      : std_logic_vector( 7 downto 0) := 8x"FF";
+  signal tx_fill                       : unsigned(TXBUF_ADDR_BITS-1 downto 0);
+  signal tx_space                      : unsigned(TXBUF_ADDR_BITS-1 downto 0);
+
+  -- RX frame buffer and state. Words between the frame and write
+  -- pointers are of a frame still being received.
+  signal rxmem                         : rx_mem_t;
+  signal rx_cap_wptr                   : unsigned(RXBUF_ADDR_BITS-1 downto 0) := (others => '0');
+  signal rx_frm_wptr                   : unsigned(RXBUF_ADDR_BITS-1 downto 0) := (others => '0');
+  signal rx_cap_rptr                   : unsigned(RXBUF_ADDR_BITS-1 downto 0) := (others => '0');
+  signal rx_rd_word                    : integer range 0 to 2 := 0;
+  signal rx_in_frame                   : std_logic := '0';
+  signal rx_dropping                   : std_logic := '0';
+  signal rx_ovfl_count                 : unsigned(15 downto 0) := (others => '0');
+  signal rx_frm_count                  : unsigned(15 downto 0) := (others => '0');
+  signal rx_idle                       : std_logic;
+  signal rx_sof                        : std_logic;
+  signal rx_eof                        : std_logic;
+  signal rx_cap_count                  : unsigned(RXBUF_ADDR_BITS-1 downto 0);
+
+  -- Interrupt enable, and RX frame interrupt
+  signal rx_irq_en                     : std_logic := '0';
+  signal rx_irq                        : std_logic;
+
+  -- Idle wait deadline tick, RX frame count at the start of the wait, and
+  -- read acknowledge held off whilst waiting
+  signal idle_deadline                 : unsigned(31 downto 0) := (others => '0');
+  signal idle_frm_count                : unsigned(15 downto 0) := (others => '0');
+  signal idle_wait                     : std_logic;
+  signal rd_ack                        : std_logic;
+
 begin
 
   -----------------------------------------
@@ -78,6 +164,34 @@ begin
   rxd_int                              <=  rxd after 1 ns;
   rxc_int                              <=  rxc after 1 ns;
 
+  -- TX output from the FIFO when playing, else as written by VProc
+  txd                                  <= txd_play when tx_play_en = '1' else txd_vp;
+  txc                                  <= txc_play when tx_play_en = '1' else txc_vp;
+
+  -- Committed words waiting to be sent, and free FIFO space (one entry is
+  -- always left empty to distinguish full from empty)
+  tx_fill                              <= tx_commit_ptr - tx_rd_ptr;
+  tx_space                             <= tx_rd_ptr - tx_wr_ptr - 1;
+
+  rx_idle                              <= '1' when rxd_int = IDLE_WORD and rxc_int = 8x"FF" else '0';
+  rx_sof                               <= has_ctrl_char(rxd_int, rxc_int, SOF_CHAR);
+  rx_eof                               <= has_ctrl_char(rxd_int, rxc_int, EOF_CHAR);
+
+  -- Words of completely received frames available to read
+  rx_cap_count                         <= rx_frm_wptr - rx_cap_rptr;
+
+  -- Interrupt whilst completed frames are in the RX buffer
+  rx_irq                               <= '1' when rx_irq_en = '1' and rx_cap_count /= 0 else '0';
+
+  -- A read of the idle register waits until the deadline tick is reached, or
+  -- until a completed frame is in the RX buffer or has arrived since the wait
+  -- was set (in case an interrupt has already read it)
+  idle_wait                            <= '1' when Addr = IDLE_ADDR and
+                                                   signed(idle_deadline - to_unsigned(ClkCount, 32)) > 0 and
+                                                   rx_cap_count = 0 and
+                                                   rx_frm_count = idle_frm_count else '0';
+  rd_ack                               <= RD and not idle_wait;
+
   -----------------------------------------
   -- Synchronous process
   -----------------------------------------
@@ -90,48 +204,201 @@ begin
   end process;
 
   -----------------------------------------
-  -- Memory map I/O to VProc address space
+  -- Play out committed words from the TX
+  -- FIFO, one per clock. When the FIFO is
+  -- empty the output reverts to idle.
   -----------------------------------------
 
-  process(update)
+  process(clk)
   begin
+    if clk'event and clk = '1' then
 
-    if update'event then
-      DataIn <= 32x"0";
+      tx_play_en                       <= '0';
 
-      if WE ='1' or RD = '1' then
+      if tx_fill /= 0 then
+        txd_play                       <= txmem(to_integer(tx_rd_ptr))(63 downto 0);
+        txc_play                       <= txmem(to_integer(tx_rd_ptr))(71 downto 64);
+        tx_play_en                     <= '1';
+        tx_rd_ptr                      <= tx_rd_ptr + 1;
+      end if;
 
-        case Addr is
-        when TXD_LO_ADDR =>
-          DataIn                       <= rxd_int(31 downto 0);
-          if WE = '1' then
-            txd(31 downto 0)           <= DataOut;
-          end if;
+    end if;
+  end process;
 
-        when TXD_HI_ADDR =>
-          DataIn                       <= rxd_int(63 downto 32);
-          if WE = '1' then
-            txd(63 downto 32)          <= DataOut;
+  -----------------------------------------
+  -- Capture RX frames for burst reads.
+  -- Words from one containing a start-of-
+  -- frame to one containing an end-of-frame
+  -- (or an idle word, if the frame is
+  -- truncated) are stored, and made
+  -- available once the frame completes. A
+  -- frame that doesn't fit is dropped and
+  -- counted.
+  -----------------------------------------
+
+  process(clk)
+  begin
+    if clk'event and clk = '1' then
+
+      if rx_in_frame = '1' or rx_sof = '1' then
+
+        -- Store the word, unless the buffer is full or the frame is being dropped
+        if rx_dropping = '0' then
+          if rx_cap_wptr + 1 /= rx_cap_rptr then
+            rxmem(to_integer(rx_cap_wptr)) <= rxc_int & rxd_int;
+            rx_cap_wptr                <= rx_cap_wptr + 1;
+          else
+            rx_cap_wptr                <= rx_frm_wptr;
+            rx_dropping                <= '1';
+            rx_ovfl_count              <= rx_ovfl_count + 1;
           end if;
+        end if;
 
-        when TXC_ADDR =>
-          DataIn                       <= 24x"0" & rxc_int;
-          if WE = '1' then
-            txc                        <= DataOut(7 downto 0);
+        -- At the end of the frame, make the stored words available
+        if rx_in_frame = '1' and (rx_eof = '1' or rx_idle = '1') then
+          rx_in_frame                  <= '0';
+          rx_dropping                  <= '0';
+
+          if rx_dropping = '0' and rx_cap_wptr + 1 /= rx_cap_rptr then
+            rx_frm_wptr                <= rx_cap_wptr + 1;
+            rx_frm_count               <= rx_frm_count + 1;
           end if;
+        else
+          rx_in_frame                  <= '1';
+        end if;
+
+      end if;
+
+    end if;
+  end process;
 
-        when TICKS_ADDR =>
-          DataIn                       <= std_logic_vector(to_unsigned(ClkCount, 32));
+  -----------------------------------------
+  -- Memory map I/O to VProc address space
+  -----------------------------------------
+
+  process(update)
+  begin
 
-        when HLT_ADDR =>
+    if update'event then
+      DataIn <= 32x"0";
+
+      if WE ='1' or RD = '1' then
+
+        -- Writes to the TX buffer region are the next TXD low, TXD high and TXC
+        -- words of the next FIFO entry
+        if (Addr and BUF_ADDR_MASK) = TXBUF_ADDR then
           if WE = '1' then
-            halt                       <= DataOut(0);
+            case tx_wr_word is
+            when 0 =>
+              tx_wr_stage(31 downto 0) <= DataOut;
+              tx_wr_word               <= 1;
+            when 1 =>
+              tx_wr_stage(63 downto 32)<= DataOut;
+              tx_wr_word               <= 2;
+            when others =>
+              txmem(to_integer(tx_wr_ptr)) <= DataOut(7 downto 0) & tx_wr_stage;
+              tx_wr_ptr                <= tx_wr_ptr + 1;
+              tx_wr_word               <= 0;
+            end case;
           end if;
 
-        when others =>
-            report "***Error. tcp_ip_pg---access to invalid address from VProc" severity error;
+        -- Reads from the RX buffer region return the next RXD low, RXD high and RXC
+        -- words of the oldest captured entry
+        elsif (Addr and BUF_ADDR_MASK) = RXBUF_ADDR then
+          case rx_rd_word is
+          when 0 =>
+            DataIn                     <= rxmem(to_integer(rx_cap_rptr))(31 downto 0);
+          when 1 =>
+            DataIn                     <= rxmem(to_integer(rx_cap_rptr))(63 downto 32);
+          when others =>
+            DataIn                     <= 24x"0" & rxmem(to_integer(rx_cap_rptr))(71 downto 64);
+          end case;
+
+          if RD = '1' then
+            if rx_rd_word = 2 then
+              rx_cap_rptr              <= rx_cap_rptr + 1;
+              rx_rd_word               <= 0;
+            else
+              rx_rd_word               <= rx_rd_word + 1;
+            end if;
+          end if;
 
-        end case;
+        else
+
+          case Addr is
+          when TXD_LO_ADDR =>
+            DataIn                     <= rxd_int(31 downto 0);
+            if WE = '1' then
+              txd_vp(31 downto 0)      <= DataOut;
+            end if;
+
+          when TXD_HI_ADDR =>
+            DataIn                     <= rxd_int(63 downto 32);
+            if WE = '1' then
+              txd_vp(63 downto 32)     <= DataOut;
+            end if;
+
+          when TXC_ADDR =>
+            DataIn                     <= 24x"0" & rxc_int;
+            if WE = '1' then
+              txc_vp                   <= DataOut(7 downto 0);
+            end if;
+
+          when TICKS_ADDR =>
+            DataIn                     <= std_logic_vector(to_unsigned(ClkCount, 32));
+
+          when HLT_ADDR =>
+            if WE = '1' then
+              halt                     <= DataOut(0);
+            end if;
+
+          -- A write commits the specified number of written words to the TX FIFO
+          -- to be sent, discarding any other uncommitted words. A read returns
+          -- the number of committed words still to be sent.
+          when TXSEND_ADDR =>
+            DataIn                     <= std_logic_vector(resize(tx_fill, 32));
+            if WE = '1' then
+              tx_commit_ptr            <= tx_commit_ptr + unsigned(DataOut(TXBUF_ADDR_BITS-1 downto 0));
+              tx_wr_ptr                <= tx_commit_ptr + unsigned(DataOut(TXBUF_ADDR_BITS-1 downto 0));
+              tx_wr_word               <= 0;
+            end if;
+
+          -- A read returns the number of free words in the TX FIFO
+          when TXSPACE_ADDR =>
+            DataIn                     <= std_logic_vector(resize(tx_space, 32));
+
+          -- A read returns the RX buffer dropped frame count and number of words
+          -- of completed frames. A write discards all completed frames.
+          when RXCOUNT_ADDR =>
+            DataIn                     <= std_logic_vector(rx_ovfl_count) &
+                                          std_logic_vector(resize(rx_cap_count, 16));
+            if WE = '1' then
+              rx_cap_rptr              <= rx_frm_wptr;
+              rx_rd_word               <= 0;
+            end if;
+
+          -- A write sets the idle deadline to the given number of ticks from
+          -- now. A read is not acknowledged until the deadline, or until a
+          -- frame has been received, and returns the ticks remaining.
+          when IDLE_ADDR =>
+            DataIn                     <= std_logic_vector(idle_deadline - to_unsigned(ClkCount, 32));
+            if WE = '1' then
+              idle_deadline            <= to_unsigned(ClkCount, 32) + unsigned(DataOut);
+              idle_frm_count           <= rx_frm_count;
+            end if;
+
+          -- Bit 0 enables the interrupt for completed RX frames
+          when IRQEN_ADDR =>
+            DataIn                     <= 31x"0" & rx_irq_en;
+            if WE = '1' then
+              rx_irq_en                <= DataOut(0);
+            end if;
+
+          when others =>
+              report "***Error. tcp_ip_pg---access to invalid address from VProc" severity error;
+
+          end case;
+        end if;
       end if;
 
       -- Finished processing, so flag to VProc
@@ -153,8 +420,8 @@ begin
     DataOut                            => DataOut,
     DataIn                             => DataIn,
     WRAck                              => WE,
-    RDAck                              => RD,
-    Interrupt                          => 3x"000",
+    RDAck                              => rd_ack,
+    Interrupt                          => "00" & rx_irq,
     Update                             => update,
     UpdateResponse                     => updateResponse,
     Node                               => std_logic_vector(to_unsigned(NODE_NUM, 4))